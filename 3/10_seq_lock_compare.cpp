@@ -1,6 +1,15 @@
+#include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <mutex>
 #include <print>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 class Y {
 private:
@@ -13,6 +22,11 @@ private:
 public:
 	Y(int sd) :some_detail(sd) {}
 
+	void set_detail(int sd) {
+		std::lock_guard<std::mutex> lock_a(m);
+		some_detail = sd;
+	}
+
 	friend bool operator == (Y const& lhs, Y const& rhs) {
 		if (&lhs == &rhs)
 			return true;
@@ -29,6 +43,11 @@ private:
 public:
 	Y2(int sd) : some_detail(sd) {}
 
+	void set_detail(int sd) {
+		std::lock_guard<std::mutex> lock_a(m);
+		some_detail = sd;
+	}
+
 	friend bool operator == (Y2 const& lhs, Y2 const& rhs) {
 		if (&lhs == &rhs)
 			return true;
@@ -38,10 +57,140 @@ public:
 	}
 };
 
-int main() {
+// Sequence lock: a writer makes the sequence odd, updates the value and makes it even again.
+// A reader copies the value between two reads of the sequence and retries if a write was
+// in progress or the sequence moved, so readers never write to shared memory. The value is
+// held as relaxed atomic words, which keeps a copy that races with a writer well defined.
+template<typename T> requires std::is_trivially_copyable_v<T>
+class seqlock {
+	static constexpr std::size_t num_words = (sizeof(T) + sizeof(std::uintptr_t) - 1) / sizeof(std::uintptr_t);
+
+	std::atomic<unsigned> sequence{ 0 };
+	std::array<std::atomic<std::uintptr_t>, num_words> words;
+
+	void store_words(T const& value) {
+		std::uintptr_t buffer[num_words] = {};
+		std::memcpy(buffer, &value, sizeof(T));
+		for (std::size_t i = 0; i < num_words; ++i) {
+			words[i].store(buffer[i], std::memory_order_relaxed);
+		}
+	}
+
+public:
+	explicit seqlock(T const& value = T()) {
+		store_words(value);
+	}
+
+	seqlock(seqlock const&) = delete;
+	seqlock& operator=(seqlock const&) = delete;
+
+	// waits out any write in progress; the result is passed to read_retry
+	unsigned read_begin() const {
+		unsigned seq = sequence.load(std::memory_order_acquire);
+		while (seq & 1) {
+			std::this_thread::yield();
+			seq = sequence.load(std::memory_order_acquire);
+		}
+		return seq;
+	}
+
+	// only meaningful if the following read_retry returns false
+	T load_unchecked() const {
+		std::uintptr_t buffer[num_words];
+		for (std::size_t i = 0; i < num_words; ++i) {
+			buffer[i] = words[i].load(std::memory_order_relaxed);
+		}
+		T value;
+		std::memcpy(&value, buffer, sizeof(T));
+		return value;
+	}
+
+	bool read_retry(unsigned seq) const {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return sequence.load(std::memory_order_relaxed) != seq;
+	}
+
+	T load() const {
+		while (true) {
+			unsigned const seq = read_begin();
+			T const value = load_unchecked();
+			if (!read_retry(seq)) {
+				return value;
+			}
+		}
+	}
+
+	// writers serialize among themselves by claiming the odd sequence number; the acquire on
+	// success pairs with the previous writer's release, so its word stores come before ours
+	void store(T const& value) {
+		unsigned seq = sequence.load(std::memory_order_relaxed);
+		while (true) {
+			if (seq & 1) {
+				std::this_thread::yield();
+				seq = sequence.load(std::memory_order_relaxed);
+			}
+			else if (sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				break;
+			}
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		store_words(value);
+		sequence.store(seq + 2, std::memory_order_release);
+	}
+};
+
+// Y with the detail behind a seqlock: each side is read consistently on its own
+class Y3 {
+private:
+	seqlock<int> some_detail;
+public:
+	Y3(int sd) : some_detail(sd) {}
+
+	void set_detail(int sd) {
+		some_detail.store(sd);
+	}
+
+	friend bool operator == (Y3 const& lhs, Y3 const& rhs) {
+		if (&lhs == &rhs)
+			return true;
+		int const lhs_value = lhs.some_detail.load();
+		int const rhs_value = rhs.some_detail.load();
+		return lhs_value == rhs_value;
+	}
+};
+
+// Y2 with seqlocks: both sides are read inside one retry loop, so the comparison sees a
+// snapshot of the two values as they were at the same moment
+class Y4 {
+private:
+	seqlock<int> some_detail;
+public:
+	Y4(int sd) : some_detail(sd) {}
+
+	void set_detail(int sd) {
+		some_detail.store(sd);
+	}
+
+	friend bool operator == (Y4 const& lhs, Y4 const& rhs) {
+		if (&lhs == &rhs)
+			return true;
+		while (true) {
+			unsigned const lhs_seq = lhs.some_detail.read_begin();
+			unsigned const rhs_seq = rhs.some_detail.read_begin();
+			int const lhs_value = lhs.some_detail.load_unchecked();
+			int const rhs_value = rhs.some_detail.load_unchecked();
+			if (!lhs.some_detail.read_retry(lhs_seq) && !rhs.some_detail.read_retry(rhs_seq)) {
+				return lhs_value == rhs_value;
+			}
+		}
+	}
+};
+
+template<typename T>
+void run_single_thread(std::string const& name) {
 	int num_iterations = 10000000;
-	auto obj1 = Y(1);
-	auto obj2 = Y(1);
+	T obj1(1);
+	T obj2(1);
 	auto start = std::chrono::high_resolution_clock::now();
 	for (int i = 0; i < num_iterations; ++i) {
 		bool eq = (obj1 == obj2);
@@ -49,17 +198,61 @@ int main() {
 	}
 	auto end = std::chrono::high_resolution_clock::now();
 	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-	std::println("Time taken for Y comparison: {} ms", duration);
+	std::println("Time taken for {} comparison: {} ms", name, duration);
+}
 
-	auto obj3 = Y2(1);
-	auto obj4 = Y2(1);
-	start = std::chrono::high_resolution_clock::now();
-	for (int i = 0; i < num_iterations; ++i) {
-		bool eq = (obj3 == obj4);
-		(void)eq;
+// readers keep comparing two objects for a fixed time while one writer keeps updating one of them
+template<typename T>
+void run_readers_and_writer(std::string const& name, int num_readers) {
+	auto const run_time = std::chrono::milliseconds(200);
+	T obj1(1);
+	T obj2(1);
+
+	std::atomic<bool> done{ false };
+	std::atomic<long long> total_comparisons{ 0 };
+	long long writes = 0;
+	std::vector<std::thread> readers;
+	for (int r = 0; r < num_readers; ++r) {
+		readers.emplace_back([&obj1, &obj2, &done, &total_comparisons]() {
+			long long comparisons = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				bool eq = (obj1 == obj2);
+				(void)eq;
+				++comparisons;
+			}
+			total_comparisons += comparisons;
+			});
+	}
+	std::thread writer([&obj1, &done, &writes]() {
+		while (!done.load(std::memory_order_relaxed)) {
+			obj1.set_detail(int(writes % 2) + 1);
+			++writes;
+			std::this_thread::sleep_for(std::chrono::microseconds(10));
+		}
+		});
+	std::this_thread::sleep_for(run_time);
+	done.store(true);
+	for (auto& t : readers) {
+		t.join();
+	}
+	writer.join();
+
+	double const seconds = std::chrono::duration<double>(run_time).count();
+	std::println("{:<3} {:>2} readers + 1 writer: {:>7.2f} M comparisons/s, {:>6} writes",
+		name, num_readers, total_comparisons.load() / seconds / 1e6, writes);
+}
+
+int main() {
+	run_single_thread<Y>("Y");
+	run_single_thread<Y2>("Y2");
+	run_single_thread<Y3>("Y3");
+	run_single_thread<Y4>("Y4");
+
+	for (int num_readers : { 1, 2, 4, 8 }) {
+		run_readers_and_writer<Y>("Y", num_readers);
+		run_readers_and_writer<Y2>("Y2", num_readers);
+		run_readers_and_writer<Y3>("Y3", num_readers);
+		run_readers_and_writer<Y4>("Y4", num_readers);
 	}
-	end = std::chrono::high_resolution_clock::now();
-	duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-	std::println("Time taken for Y2 comparison: {} ms", duration);
 	return 0;
 }
@@ -1,8 +1,16 @@
 #include <atomic>
 #include <chrono>
-#include <iostream>
+#include <concepts>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <latch>
 #include <mutex>
+#include <new>
+#include <print>
+#include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 class Connection {
@@ -86,31 +94,156 @@ public:
 	}
 };
 
+// Lazily constructed value. Once initialized, get() is a single acquire load and a branch.
+// The first caller constructs the value in place; callers that arrive meanwhile sleep in
+// atomic::wait instead of spinning, and are woken when construction finishes. If the
+// initializer throws, the state goes back to uninitialized and the next caller tries again.
+template<typename T>
+class lazy {
+	enum state_type : unsigned char { uninitialized, initializing, initialized };
+
+	std::atomic<state_type> state{ uninitialized };
+	alignas(T) std::byte storage[sizeof(T)];
+
+	T& value() {
+		return *std::launder(reinterpret_cast<T*>(storage));
+	}
+
+	template<typename Init>
+	T& get_slow(Init& init) {
+		state_type current = state.load(std::memory_order_acquire);
+		while (current != initialized) {
+			if (current == uninitialized) {
+				if (state.compare_exchange_strong(current, initializing, std::memory_order_acquire)) {
+					try {
+						::new (static_cast<void*>(storage)) T(std::invoke(init));
+					}
+					catch (...) {
+						state.store(uninitialized, std::memory_order_release);
+						state.notify_all();
+						throw;
+					}
+					state.store(initialized, std::memory_order_release);
+					state.notify_all();
+					break;
+				}
+			}
+			else {
+				state.wait(initializing, std::memory_order_acquire);
+				current = state.load(std::memory_order_acquire);
+			}
+		}
+		return value();
+	}
+
+public:
+	lazy() {}
+
+	~lazy() {
+		if (state.load(std::memory_order_relaxed) == initialized) {
+			std::destroy_at(&value());
+		}
+	}
+
+	lazy(lazy const&) = delete;
+	lazy& operator=(lazy const&) = delete;
+
+	template<typename Init> requires std::convertible_to<std::invoke_result_t<Init&>, T>
+	T& get(Init init) {
+		if (state.load(std::memory_order_acquire) == initialized) {
+			return value();
+		}
+		return get_slow(init);
+	}
+};
+
+class LazyX {
+	lazy<Connection> connection;
+
+	static Connection open_connection() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return Connection();
+	}
+public:
+	void send_data() {
+		connection.get(&LazyX::open_connection).send();
+	}
+};
+
+// A function-local static is initialized once per program rather than once per object,
+// so each benchmark row instantiates a fresh copy to get a cold start.
+template<int Instance>
+class StaticX {
+	static Connection open_connection() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return Connection();
+	}
+public:
+	void send_data() {
+		static Connection connection = open_connection();
+		connection.send();
+	}
+};
+
+// Cold start: all threads are released at once onto a fresh object, so one initializes and
+// the rest wait. CPU time counts how much the waiters burn while the initializer sleeps.
+// Steady state: every call after that takes the already-initialized fast path.
 template <typename T>
-void run_benchmark(const std::string& name) {
+void run_benchmark(const std::string& name, int num_threads) {
 	T obj;
-	const int num_threads = 4;
-	const int num_iterations = 10000000;
+	const int num_iterations = 1000000;
+	std::latch start_line(num_threads + 1);
+	std::latch cold_done(num_threads);
+	std::latch steady_line(num_threads + 1);
 	std::vector<std::thread> threads;
-	auto start = std::chrono::high_resolution_clock::now();
 	for (int i = 0; i < num_threads; ++i) {
-		threads.emplace_back([&obj, num_iterations]() {
+		threads.emplace_back([&obj, &start_line, &cold_done, &steady_line]() {
+			start_line.arrive_and_wait();
+			obj.send_data();
+			cold_done.count_down();
+			steady_line.arrive_and_wait();
 			for (int j = 0; j < num_iterations; ++j) {
 				obj.send_data();
 			}
 			});
 	}
+	std::clock_t const cold_cpu_start = std::clock();
+	auto const cold_start = std::chrono::high_resolution_clock::now();
+	start_line.arrive_and_wait();
+	cold_done.wait();
+	auto const cold_end = std::chrono::high_resolution_clock::now();
+	std::clock_t const cold_cpu_end = std::clock();
+
+	auto const steady_start = std::chrono::high_resolution_clock::now();
+	steady_line.arrive_and_wait();
 	for (auto& t : threads)
 		t.join();
-	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double, std::milli> duration = end - start;
-	std::cout << name << ": " << duration.count() << " ms" << std::endl;
+	auto const steady_end = std::chrono::high_resolution_clock::now();
+
+	std::chrono::duration<double, std::milli> const cold = cold_end - cold_start;
+	double const cold_cpu = 1000.0 * (cold_cpu_end - cold_cpu_start) / CLOCKS_PER_SEC;
+	std::chrono::duration<double, std::nano> const steady = steady_end - steady_start;
+	std::println("{:<30} {:>2} threads | cold: {:>6.2f} ms wall, {:>6.2f} ms cpu | steady: {:>5.2f} ns/call",
+		name, num_threads, cold.count(), cold_cpu, steady.count() / (double(num_threads) * num_iterations));
+}
+
+template<int Row>
+void run_benchmark_row(int num_threads) {
+	run_benchmark<ModernX>("Modern (std::call_once)", num_threads);
+	run_benchmark<OldX>("Old (Double-Checked Locking)", num_threads);
+	run_benchmark<TwoFlagsX>("TwoFlagsX", num_threads);
+	run_benchmark<LazyX>("lazy<T>", num_threads);
+	run_benchmark<StaticX<Row>>("function-local static", num_threads);
 }
 
 int main() {
-	run_benchmark<ModernX>("Modern (std::call_once)");
-	run_benchmark<OldX>("Old (Double-Checked Locking)");
-	run_benchmark<TwoFlagsX>("TwoFlagsX");
+	run_benchmark_row<0>(1);
+	run_benchmark_row<1>(2);
+	run_benchmark_row<2>(4);
+	run_benchmark_row<3>(8);
+	run_benchmark_row<4>(16);
+	run_benchmark_row<5>(32);
+	run_benchmark_row<6>(64);
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #include <map> 
 #include <mutex>
+#include <optional>
 #include <print>
 #include <shared_mutex> 
 #include <string> 
@@ -7,24 +8,26 @@
 
 class dns_entry {};
 
+// SharedMutex can be swapped for any type with lock/unlock and lock_shared/unlock_shared
+template<typename SharedMutex = std::shared_mutex>
 class dns_cache {
 	std::map<std::string, dns_entry> entries;
-	mutable std::shared_mutex entry_mutex;
+	mutable SharedMutex entry_mutex;
 public:
 	std::optional<dns_entry> find_entry(std::string const& domain) const {
-		std::shared_lock<std::shared_mutex> lk(entry_mutex);
+		std::shared_lock<SharedMutex> lk(entry_mutex);
 		auto const it = entries.find(domain);
 		return (it == entries.end()) ? std::nullopt : std::optional<dns_entry>(it->second);
 	}
 
 	void update_or_add_entry(std::string const& domain, dns_entry const& dns_details) {
-		std::lock_guard<std::shared_mutex> lk(entry_mutex);
+		std::lock_guard<SharedMutex> lk(entry_mutex);
 		entries[domain] = dns_details;
 	}
 };
 
 int main() {
-	dns_cache cache;
+	dns_cache<> cache;
 	std::thread th1 = std::thread([&cache]() {
 		std::println("Thread 1: Looking up example.com");
 		auto entry = cache.find_entry("example.com");
@@ -0,0 +1,256 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class dns_entry {
+public:
+	std::string address;
+};
+
+// Listing 3.13
+class dns_cache {
+	std::map<std::string, dns_entry> entries;
+	mutable std::shared_mutex entry_mutex;
+public:
+	std::optional<dns_entry> find_entry(std::string const& domain) const {
+		std::shared_lock<std::shared_mutex> lk(entry_mutex);
+		auto const it = entries.find(domain);
+		return (it == entries.end()) ? std::nullopt : std::optional<dns_entry>(it->second);
+	}
+
+	void update_or_add_entry(std::string const& domain, dns_entry const& dns_details) {
+		std::lock_guard<std::shared_mutex> lk(entry_mutex);
+		entries[domain] = dns_details;
+	}
+
+	void update_or_add_entries(std::vector<std::pair<std::string, dns_entry>> const& batch) {
+		std::lock_guard<std::shared_mutex> lk(entry_mutex);
+		for (auto const& [domain, dns_details] : batch) {
+			entries[domain] = dns_details;
+		}
+	}
+};
+
+// User-space RCU. Each reader thread owns a padded slot and, while reading, records the grace
+// period it started in; it never writes anything another reader touches. A writer that has
+// unpublished an old version starts a new grace period and waits until every slot is idle or
+// has moved on, after which nobody can still be looking at the old version.
+unsigned const max_rcu_readers = 128;
+
+struct alignas(std::hardware_destructive_interference_size) rcu_reader_slot {
+	std::atomic<std::thread::id> id;
+	std::atomic<std::uint64_t> period{ 0 }; // 0 while not reading
+};
+
+rcu_reader_slot rcu_reader_slots[max_rcu_readers];
+alignas(std::hardware_destructive_interference_size) std::atomic<std::uint64_t> rcu_grace_period{ 1 };
+
+class rcu_slot_owner {
+	rcu_reader_slot* slot;
+public:
+	rcu_slot_owner(rcu_slot_owner const&) = delete;
+	rcu_slot_owner& operator=(rcu_slot_owner const&) = delete;
+
+	rcu_slot_owner() : slot(nullptr) {
+		for (unsigned i = 0; i < max_rcu_readers; ++i) {
+			std::thread::id old_id;
+			if (rcu_reader_slots[i].id.compare_exchange_strong(old_id, std::this_thread::get_id())) {
+				slot = &rcu_reader_slots[i];
+				break;
+			}
+		}
+		if (!slot) {
+			throw std::runtime_error("No RCU reader slots available");
+		}
+	}
+
+	std::atomic<std::uint64_t>& get_period() {
+		return slot->period;
+	}
+
+	~rcu_slot_owner() {
+		slot->period.store(0);
+		slot->id.store(std::thread::id());
+	}
+};
+
+std::atomic<std::uint64_t>& get_rcu_period_for_current_thread() {
+	thread_local static rcu_slot_owner owner;
+	return owner.get_period();
+}
+
+class rcu_read_guard {
+	std::atomic<std::uint64_t>& period;
+public:
+	rcu_read_guard(rcu_read_guard const&) = delete;
+	rcu_read_guard& operator=(rcu_read_guard const&) = delete;
+
+	rcu_read_guard() : period(get_rcu_period_for_current_thread()) {
+		period.store(rcu_grace_period.load());
+	}
+
+	~rcu_read_guard() {
+		period.store(0, std::memory_order_release);
+	}
+};
+
+void synchronize_rcu() {
+	std::uint64_t const target = rcu_grace_period.fetch_add(1) + 1;
+	for (unsigned i = 0; i < max_rcu_readers; ++i) {
+		while (true) {
+			std::uint64_t const period = rcu_reader_slots[i].period.load();
+			if (period == 0 || period >= target) {
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
+
+// Readers load the current immutable snapshot and search it without locking. Writers copy
+// the snapshot, apply a whole batch, publish the copy and free the old one after a grace period.
+class rcu_dns_cache {
+	typedef std::map<std::string, dns_entry> snapshot;
+	std::atomic<snapshot const*> entries;
+	std::mutex writer_mutex;
+
+	void publish(snapshot const* next) {
+		snapshot const* const previous = entries.exchange(next);
+		synchronize_rcu();
+		delete previous;
+	}
+
+public:
+	rcu_dns_cache() : entries(new snapshot) {}
+
+	~rcu_dns_cache() {
+		delete entries.load();
+	}
+
+	rcu_dns_cache(rcu_dns_cache const& other) = delete;
+	rcu_dns_cache& operator=(rcu_dns_cache const& other) = delete;
+
+	std::optional<dns_entry> find_entry(std::string const& domain) const {
+		rcu_read_guard guard;
+		snapshot const& current = *entries.load();
+		auto const it = current.find(domain);
+		return (it == current.end()) ? std::nullopt : std::optional<dns_entry>(it->second);
+	}
+
+	void update_or_add_entry(std::string const& domain, dns_entry const& dns_details) {
+		update_or_add_entries({ { domain, dns_details } });
+	}
+
+	// one copy and one grace period for the whole batch
+	void update_or_add_entries(std::vector<std::pair<std::string, dns_entry>> const& batch) {
+		std::lock_guard<std::mutex> lk(writer_mutex);
+		snapshot* const next = new snapshot(*entries.load());
+		for (auto const& [domain, dns_details] : batch) {
+			(*next)[domain] = dns_details;
+		}
+		publish(next);
+	}
+};
+
+std::string domain_name(int i) {
+	return "host" + std::to_string(i) + ".example.com";
+}
+
+// readers look up random domains for a fixed time while a writer keeps publishing batches
+template<typename Cache>
+void run_benchmark(std::string const& name, int num_readers) {
+	const int num_domains = 10000;
+	const int batch_size = 16;
+	auto const run_time = std::chrono::milliseconds(200);
+
+	Cache cache;
+	std::vector<std::pair<std::string, dns_entry>> initial;
+	for (int i = 0; i < num_domains; ++i) {
+		initial.emplace_back(domain_name(i), dns_entry{ "10.0.0.1" });
+	}
+	cache.update_or_add_entries(initial);
+
+	std::atomic<bool> done{ false };
+	std::atomic<long long> total_lookups{ 0 };
+	int batches = 0;
+	std::vector<std::thread> readers;
+	for (int r = 0; r < num_readers; ++r) {
+		readers.emplace_back([&cache, &done, &total_lookups, r]() {
+			std::mt19937 gen(r);
+			std::uniform_int_distribution<int> dist(0, num_domains - 1);
+			long long lookups = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				bool const found = cache.find_entry(domain_name(dist(gen))).has_value();
+				assert(found);
+				(void)found;
+				++lookups;
+			}
+			total_lookups += lookups;
+			});
+	}
+	std::thread writer([&cache, &done, &batches]() {
+		std::mt19937 gen(42);
+		std::uniform_int_distribution<int> dist(0, num_domains - 1);
+		while (!done.load(std::memory_order_relaxed)) {
+			std::vector<std::pair<std::string, dns_entry>> batch;
+			for (int i = 0; i < batch_size; ++i) {
+				batch.emplace_back(domain_name(dist(gen)), dns_entry{ "10.0.0." + std::to_string(i) });
+			}
+			cache.update_or_add_entries(batch);
+			++batches;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		});
+	std::this_thread::sleep_for(run_time);
+	done.store(true);
+	for (auto& t : readers) {
+		t.join();
+	}
+	writer.join();
+
+	double const seconds = std::chrono::duration<double>(run_time).count();
+	std::println("{:<24} {:>2} readers: {:>8.2f} M lookups/s, {:>4} batches published",
+		name, num_readers, total_lookups.load() / seconds / 1e6, batches);
+}
+
+int main() {
+	rcu_dns_cache cache;
+	{
+		std::jthread reader([&cache]() {
+			for (int i = 0; i < 1000; ++i) {
+				std::optional<dns_entry> const entry = cache.find_entry("example.com");
+				assert(!entry || entry->address.starts_with("192.168.0."));
+			}
+			});
+		std::jthread writer([&cache]() {
+			for (int i = 0; i < 100; ++i) {
+				cache.update_or_add_entry("example.com", dns_entry{ "192.168.0." + std::to_string(i) });
+			}
+			});
+	}
+	assert(cache.find_entry("example.com")->address == "192.168.0.99");
+	assert(!cache.find_entry("example.org"));
+	cache.update_or_add_entries({ { "example.org", dns_entry{ "10.1.1.1" } }, { "example.com", dns_entry{ "10.2.2.2" } } });
+	assert(cache.find_entry("example.org")->address == "10.1.1.1");
+	assert(cache.find_entry("example.com")->address == "10.2.2.2");
+	std::println("Test passed!");
+
+	for (int num_readers : { 1, 2, 4, 8, 16, 32, 64 }) {
+		run_benchmark<dns_cache>("shared_mutex dns_cache", num_readers);
+		run_benchmark<rcu_dns_cache>("rcu_dns_cache", num_readers);
+	}
+	return 0;
+}
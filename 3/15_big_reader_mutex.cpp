@@ -0,0 +1,140 @@
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "big_reader_mutex.h"
+
+class dns_entry {
+public:
+	std::string address;
+};
+
+// Listing 3.13 with the reader-writer lock as a parameter
+template<typename SharedMutex = std::shared_mutex>
+class dns_cache {
+	std::map<std::string, dns_entry> entries;
+	mutable SharedMutex entry_mutex;
+public:
+	std::optional<dns_entry> find_entry(std::string const& domain) const {
+		std::shared_lock<SharedMutex> lk(entry_mutex);
+		auto const it = entries.find(domain);
+		return (it == entries.end()) ? std::nullopt : std::optional<dns_entry>(it->second);
+	}
+
+	void update_or_add_entry(std::string const& domain, dns_entry const& dns_details) {
+		std::lock_guard<SharedMutex> lk(entry_mutex);
+		entries[domain] = dns_details;
+	}
+};
+
+// empty critical sections, so the lock itself is all that is measured; one op in 1000 writes
+template<typename SharedMutex>
+void run_lock_benchmark(std::string const& name, int num_threads) {
+	const int ops_per_thread = 1000000;
+	SharedMutex mutex;
+	long shared_value = 0;
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&mutex, &shared_value]() {
+			long seen = 0;
+			for (int i = 0; i < ops_per_thread; ++i) {
+				if (i % 1000 == 0) {
+					std::lock_guard<SharedMutex> lk(mutex);
+					++shared_value;
+				}
+				else {
+					std::shared_lock<SharedMutex> lk(mutex);
+					seen += shared_value;
+				}
+			}
+			assert(seen >= 0);
+			(void)seen;
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::nano> duration = end - start;
+	assert(shared_value == long(num_threads) * ops_per_thread / 1000);
+	std::println("{:<18} {:>2} threads: {:.1f} ns/op", name, num_threads, duration.count() / (double(num_threads) * ops_per_thread));
+}
+
+template<typename SharedMutex>
+void run_cache_benchmark(std::string const& name) {
+	const int num_domains = 1000;
+	const int num_threads = 4;
+	const int lookups_per_thread = 500000;
+
+	dns_cache<SharedMutex> cache;
+	std::vector<std::string> domains;
+	for (int i = 0; i < num_domains; ++i) {
+		domains.push_back("host" + std::to_string(i) + ".example.com");
+		cache.update_or_add_entry(domains.back(), dns_entry{ "10.0.0.1" });
+	}
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&cache, &domains, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int> dist(0, num_domains - 1);
+			for (int i = 0; i < lookups_per_thread; ++i) {
+				bool const found = cache.find_entry(domains[dist(gen)]).has_value();
+				assert(found);
+				(void)found;
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("dns_cache<{}>: {} lookups in {:.1f} ms", name, num_threads * lookups_per_thread, duration.count());
+}
+
+int main() {
+	dns_cache<big_reader_mutex> cache;
+	std::thread th1 = std::thread([&cache]() {
+		for (int i = 0; i < 1000; ++i) {
+			std::optional<dns_entry> const entry = cache.find_entry("example.com");
+			assert(!entry || entry->address.starts_with("192.168.0."));
+		}
+		});
+	std::thread th2 = std::thread([&cache]() {
+		for (int i = 0; i < 100; ++i) {
+			cache.update_or_add_entry("example.com", dns_entry{ "192.168.0." + std::to_string(i) });
+		}
+		});
+	th2.join();
+	th1.join();
+	assert(cache.find_entry("example.com")->address == "192.168.0.99");
+
+	big_reader_mutex mutex(4);
+	assert(mutex.try_lock_shared());
+	assert(!mutex.try_lock());
+	mutex.unlock_shared();
+	assert(mutex.try_lock());
+	assert(!mutex.try_lock_shared());
+	mutex.unlock();
+	std::println("Test passed!");
+
+	for (int num_threads : { 1, 2, 4, 8 }) {
+		run_lock_benchmark<std::shared_mutex>("std::shared_mutex", num_threads);
+		run_lock_benchmark<big_reader_mutex>("big_reader_mutex", num_threads);
+	}
+	run_cache_benchmark<std::shared_mutex>("std::shared_mutex");
+	run_cache_benchmark<big_reader_mutex>("big_reader_mutex");
+	return 0;
+}
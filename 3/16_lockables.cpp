@@ -0,0 +1,496 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <print>
+#include <stack>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+template<typename M>
+concept lockable = requires(M m) {
+	m.lock();
+	m.unlock();
+	{ m.try_lock() } -> std::same_as<bool>;
+};
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	_mm_pause();
+#endif
+}
+
+// Exponential backoff for spin loops: pause for 1, 2, 4, ... iterations, and once the limit
+// is reached give the time slice away, since the thread we are waiting for may not be running.
+class spin_backoff {
+	static constexpr unsigned max_spins = 1024;
+	unsigned spins = 1;
+public:
+	void pause() {
+		if (spins <= max_spins) {
+			for (unsigned i = 0; i < spins; ++i) {
+				cpu_relax();
+			}
+			spins *= 2;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+};
+
+// Test-and-test-and-set: waiters spin on a plain load, which stays in their own cache, and
+// only try the exchange once the lock looks free. A failed exchange backs off further.
+class ttas_mutex {
+	std::atomic<bool> locked{ false };
+public:
+	void lock() {
+		spin_backoff backoff;
+		while (true) {
+			while (locked.load(std::memory_order_relaxed)) {
+				backoff.pause();
+			}
+			if (!locked.exchange(true, std::memory_order_acquire)) {
+				return;
+			}
+			backoff.pause();
+		}
+	}
+
+	bool try_lock() {
+		return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+	}
+
+	void unlock() {
+		locked.store(false, std::memory_order_release);
+	}
+};
+
+// Ticket lock: FIFO, each thread takes a number and waits until it is being served
+class ticket_mutex {
+	alignas(std::hardware_destructive_interference_size) std::atomic<unsigned> next_ticket{ 0 };
+	alignas(std::hardware_destructive_interference_size) std::atomic<unsigned> now_serving{ 0 };
+public:
+	void lock() {
+		unsigned const ticket = next_ticket.fetch_add(1, std::memory_order_relaxed);
+		spin_backoff backoff;
+		while (now_serving.load(std::memory_order_acquire) != ticket) {
+			backoff.pause();
+		}
+	}
+
+	bool try_lock() {
+		unsigned current = now_serving.load(std::memory_order_relaxed);
+		return next_ticket.compare_exchange_strong(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	void unlock() {
+		now_serving.store(now_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+};
+
+// MCS queue lock: waiters form a linked queue and each spins on a flag in its own node, so a
+// release touches only the next waiter's cache line. The Lockable interface has nowhere to
+// pass the node, so each thread keeps a few nodes of its own and the holder's node is
+// remembered in the mutex.
+class mcs_mutex {
+	struct alignas(std::hardware_destructive_interference_size) node {
+		std::atomic<node*> next{ nullptr };
+		std::atomic<bool> locked{ false };
+	};
+
+	// enough for one thread to hold this many MCS locks at once
+	static constexpr unsigned max_held = 8;
+
+	struct thread_nodes {
+		node nodes[max_held];
+		unsigned in_use = 0;
+
+		node* acquire() {
+			for (unsigned i = 0; i < max_held; ++i) {
+				if (!(in_use & (1u << i))) {
+					in_use |= 1u << i;
+					return &nodes[i];
+				}
+			}
+			std::terminate();
+		}
+
+		void release(node* n) {
+			in_use &= ~(1u << (n - nodes));
+		}
+	};
+
+	static thread_nodes& nodes_for_current_thread() {
+		thread_local thread_nodes nodes;
+		return nodes;
+	}
+
+	std::atomic<node*> tail{ nullptr };
+	node* holder = nullptr;
+
+public:
+	void lock() {
+		node* const self = nodes_for_current_thread().acquire();
+		self->next.store(nullptr, std::memory_order_relaxed);
+		self->locked.store(true, std::memory_order_relaxed);
+		if (node* const predecessor = tail.exchange(self, std::memory_order_acq_rel)) {
+			predecessor->next.store(self, std::memory_order_release);
+			spin_backoff backoff;
+			while (self->locked.load(std::memory_order_acquire)) {
+				backoff.pause();
+			}
+		}
+		holder = self;
+	}
+
+	bool try_lock() {
+		node* const self = nodes_for_current_thread().acquire();
+		self->next.store(nullptr, std::memory_order_relaxed);
+		node* expected = nullptr;
+		if (!tail.compare_exchange_strong(expected, self, std::memory_order_acquire, std::memory_order_relaxed)) {
+			nodes_for_current_thread().release(self);
+			return false;
+		}
+		holder = self;
+		return true;
+	}
+
+	void unlock() {
+		node* const self = holder;
+		node* next = self->next.load(std::memory_order_acquire);
+		if (!next) {
+			node* expected = self;
+			if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+				nodes_for_current_thread().release(self);
+				return;
+			}
+			// a successor has swapped itself in but not linked to us yet
+			while (!(next = self->next.load(std::memory_order_acquire))) {
+				cpu_relax();
+			}
+		}
+		next->locked.store(false, std::memory_order_release);
+		nodes_for_current_thread().release(self);
+	}
+};
+
+// CLH queue lock: each thread spins on its predecessor's node, and on release takes that node
+// over for its next acquisition while its own node is left to its successor. Nodes therefore
+// move between threads; spares are kept per thread and freed when the thread exits.
+class clh_mutex {
+	struct alignas(std::hardware_destructive_interference_size) node {
+		std::atomic<bool> locked{ false };
+	};
+
+	struct spare_nodes {
+		std::vector<node*> nodes;
+
+		node* acquire() {
+			if (nodes.empty()) {
+				return new node;
+			}
+			node* const n = nodes.back();
+			nodes.pop_back();
+			return n;
+		}
+
+		~spare_nodes() {
+			for (node* n : nodes) {
+				delete n;
+			}
+		}
+	};
+
+	static spare_nodes& spares_for_current_thread() {
+		thread_local spare_nodes spares;
+		return spares;
+	}
+
+	std::atomic<node*> tail;
+	node* holder = nullptr;
+	node* holder_predecessor = nullptr;
+
+public:
+	clh_mutex() : tail(new node) {}
+
+	~clh_mutex() {
+		delete tail.load();
+	}
+
+	clh_mutex(clh_mutex const&) = delete;
+	clh_mutex& operator=(clh_mutex const&) = delete;
+
+	void lock() {
+		node* const self = spares_for_current_thread().acquire();
+		self->locked.store(true, std::memory_order_relaxed);
+		node* const predecessor = tail.exchange(self, std::memory_order_acq_rel);
+		spin_backoff backoff;
+		while (predecessor->locked.load(std::memory_order_acquire)) {
+			backoff.pause();
+		}
+		holder = self;
+		holder_predecessor = predecessor;
+	}
+
+	// Only enqueues when the tail node looked released. Between that check and the CAS the
+	// node can be recycled and swapped back in as another thread's live node (ABA on tail), in
+	// which case the CAS still succeeds. The successful CAS is a real enqueue, so like lock()
+	// this waits for the predecessor; only in that rare case does try_lock actually block, and
+	// then only for the threads that were queued at the time.
+	bool try_lock() {
+		node* predecessor = tail.load(std::memory_order_relaxed);
+		if (predecessor->locked.load(std::memory_order_acquire)) {
+			return false;
+		}
+		node* const self = spares_for_current_thread().acquire();
+		self->locked.store(true, std::memory_order_relaxed);
+		if (!tail.compare_exchange_strong(predecessor, self, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			spares_for_current_thread().nodes.push_back(self);
+			return false;
+		}
+		spin_backoff backoff;
+		while (predecessor->locked.load(std::memory_order_acquire)) {
+			backoff.pause();
+		}
+		holder = self;
+		holder_predecessor = predecessor;
+		return true;
+	}
+
+	void unlock() {
+		node* const predecessor = holder_predecessor;
+		holder->locked.store(false, std::memory_order_release);
+		spares_for_current_thread().nodes.push_back(predecessor);
+	}
+};
+
+// Futex-style mutex (Drepper's "Futexes Are Tricky", mutex 2): 0 unlocked, 1 locked,
+// 2 locked with possible waiters. Waiters sleep in atomic::wait, and unlock only pays for
+// notify_one when someone may be sleeping.
+class futex_mutex {
+	std::atomic<int> state{ 0 };
+public:
+	void lock() {
+		int c = 0;
+		if (state.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+			return;
+		}
+		if (c != 2) {
+			c = state.exchange(2, std::memory_order_acquire);
+		}
+		while (c != 0) {
+			state.wait(2, std::memory_order_relaxed);
+			c = state.exchange(2, std::memory_order_acquire);
+		}
+	}
+
+	bool try_lock() {
+		int c = 0;
+		return state.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	void unlock() {
+		if (state.fetch_sub(1, std::memory_order_release) != 1) {
+			state.store(0, std::memory_order_release);
+			state.notify_one();
+		}
+	}
+};
+
+static_assert(lockable<std::mutex>);
+static_assert(lockable<ttas_mutex>);
+static_assert(lockable<ticket_mutex>);
+static_assert(lockable<mcs_mutex>);
+static_assert(lockable<clh_mutex>);
+static_assert(lockable<futex_mutex>);
+
+struct empty_stack : std::exception {
+	const char* what() const noexcept override {
+		return "empty stack";
+	}
+};
+
+// Listing 6.1 with the mutex as a parameter
+template<typename T, typename Mutex = std::mutex>
+class threadsafe_stack {
+private:
+	std::stack<T> data;
+	mutable Mutex m;
+public:
+	threadsafe_stack() {}
+
+	threadsafe_stack(const threadsafe_stack& other) {
+		std::lock_guard<Mutex> lock(other.m);
+		data = other.data;
+	}
+
+	threadsafe_stack& operator=(const threadsafe_stack&) = delete;
+
+	void push(T new_value) {
+		std::lock_guard<Mutex> lock(m);
+		data.push(std::move(new_value));
+	}
+
+	std::shared_ptr<T> pop() {
+		std::lock_guard<Mutex> lock(m);
+		if (data.empty()) throw empty_stack();
+		std::shared_ptr<T> res(std::make_shared<T>(std::move(data.top())));
+		data.pop();
+		return res;
+	}
+
+	void pop(T& value) {
+		std::lock_guard<Mutex> lock(m);
+		if (data.empty()) throw empty_stack();
+		value = std::move(data.top());
+		data.pop();
+	}
+
+	bool empty() const {
+		std::lock_guard<Mutex> lock(m);
+		return data.empty();
+	}
+};
+
+template<typename Mutex>
+void test_mutex() {
+	const int num_threads = 8;
+	const int items_per_thread = 10000;
+	threadsafe_stack<int, Mutex> stack;
+	Mutex m1;
+	Mutex m2;
+	long counter = 0;
+	{
+		std::vector<std::jthread> threads;
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&]() {
+				for (int i = 0; i < items_per_thread; ++i) {
+					stack.push(i);
+					std::scoped_lock lk(m1, m2);
+					++counter;
+				}
+				});
+		}
+	}
+	assert(counter == long(num_threads) * items_per_thread);
+	long popped = 0;
+	int value;
+	while (!stack.empty()) {
+		stack.pop(value);
+		++popped;
+	}
+	assert(popped == counter);
+	assert(m1.try_lock());
+	assert(!m1.try_lock());
+	m1.unlock();
+}
+
+// half the threads use lock() and half spin on try_lock() against the same mutex; a second
+// thread inside the critical section would see the occupancy count already raised
+template<typename Mutex>
+void test_try_lock_exclusion() {
+	const int num_threads = 4;
+	const int ops_per_thread = 5000;
+	Mutex m;
+	std::atomic<int> inside{ 0 };
+	long counter = 0;
+	{
+		std::vector<std::jthread> threads;
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < ops_per_thread; ++i) {
+					if (t % 2 == 0) {
+						m.lock();
+					}
+					else {
+						while (!m.try_lock()) {
+							std::this_thread::yield();
+						}
+					}
+					int const already_inside = inside.fetch_add(1, std::memory_order_relaxed);
+					assert(already_inside == 0);
+					(void)already_inside;
+					++counter;
+					inside.fetch_sub(1, std::memory_order_relaxed);
+					m.unlock();
+				}
+				});
+		}
+	}
+	assert(counter == long(num_threads) * ops_per_thread);
+}
+
+// a fixed number of lock/unlock pairs shared between the threads; the long critical section
+// updates a few cache lines of shared data instead of a single counter
+template<typename Mutex>
+void run_benchmark(std::string const& name, int num_threads, bool long_section) {
+	const int total_ops = 1 << 16;
+	const int ops_per_thread = total_ops / num_threads;
+	Mutex m;
+	std::uint64_t shared_data[64] = {};
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&m, &shared_data, long_section, ops_per_thread]() {
+			for (int i = 0; i < ops_per_thread; ++i) {
+				std::lock_guard<Mutex> lk(m);
+				if (long_section) {
+					for (std::uint64_t& x : shared_data) {
+						x = x * 31 + i;
+					}
+				}
+				++shared_data[0];
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("{:<12} {:<5} {:>2} threads: {:>8.1f} ns/op", name, long_section ? "long" : "short",
+		num_threads, duration.count() / (double(ops_per_thread) * num_threads));
+}
+
+template<typename Mutex>
+void run_benchmarks(std::string const& name) {
+	for (bool long_section : { false, true }) {
+		for (int num_threads : { 1, 2, 4, 8, 16, 32, 64 }) {
+			run_benchmark<Mutex>(name, num_threads, long_section);
+		}
+	}
+}
+
+int main() {
+	test_mutex<std::mutex>();
+	test_mutex<ttas_mutex>();
+	test_mutex<ticket_mutex>();
+	test_mutex<mcs_mutex>();
+	test_mutex<clh_mutex>();
+	test_mutex<futex_mutex>();
+	test_try_lock_exclusion<ttas_mutex>();
+	test_try_lock_exclusion<ticket_mutex>();
+	test_try_lock_exclusion<mcs_mutex>();
+	test_try_lock_exclusion<clh_mutex>();
+	test_try_lock_exclusion<futex_mutex>();
+	std::println("Test passed!");
+
+	run_benchmarks<std::mutex>("std::mutex");
+	run_benchmarks<ttas_mutex>("ttas_mutex");
+	run_benchmarks<ticket_mutex>("ticket_mutex");
+	run_benchmarks<mcs_mutex>("mcs_mutex");
+	run_benchmarks<clh_mutex>("clh_mutex");
+	run_benchmarks<futex_mutex>("futex_mutex");
+	return 0;
+}
@@ -0,0 +1,389 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <print>
+#include <queue>
+#include <random>
+#include <source_location>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Lock order checking is on unless NDEBUG is defined, like assert; it can also be forced
+// either way with -DLOCK_ORDER_CHECKING=0/1
+#ifndef LOCK_ORDER_CHECKING
+#ifdef NDEBUG
+#define LOCK_ORDER_CHECKING 0
+#else
+#define LOCK_ORDER_CHECKING 1
+#endif
+#endif
+
+// Learns the order in which locks are taken, across all threads, as a directed graph: an
+// edge A -> B means some thread blocked on B while holding A. A new edge that closes a cycle
+// is a potential deadlock even if the threads involved never actually collided, so it is
+// reported with the site that made the new edge and the sites of every edge on the path back.
+// Unlike hierarchical_mutex no order has to be declared up front, and locks taken in the
+// same order at any depth are fine.
+class lock_order_validator {
+	struct held_lock {
+		unsigned id;
+		char const* name;
+		std::source_location site;
+	};
+
+	struct edge {
+		char const* from_name;
+		char const* to_name;
+		std::source_location from_site;
+		std::source_location to_site;
+	};
+
+	std::atomic<unsigned> next_id{ 0 };
+	std::atomic<unsigned> violations{ 0 };
+	std::mutex graph_mutex;
+	std::unordered_map<unsigned, std::unordered_map<unsigned, edge>> graph;
+
+	static std::vector<held_lock>& held_by_current_thread() {
+		thread_local std::vector<held_lock> held;
+		return held;
+	}
+
+	// edges this thread has already checked, so the common case never touches graph_mutex
+	static std::unordered_set<std::uint64_t>& edges_seen_by_current_thread() {
+		thread_local std::unordered_set<std::uint64_t> seen;
+		return seen;
+	}
+
+	static void print_site(char const* what, char const* name, std::source_location const& site) {
+		std::println(stderr, "    {} \"{}\" at {}:{} in {}", what, name, site.file_name(), site.line(), site.function_name());
+	}
+
+	// depth-first search for a path from -> ... -> to; graph_mutex must be held
+	std::vector<edge const*> find_path(unsigned from, unsigned to) {
+		std::unordered_map<unsigned, std::pair<unsigned, edge const*>> reached_from;
+		std::vector<unsigned> pending{ from };
+		reached_from.emplace(from, std::make_pair(from, nullptr));
+		while (!pending.empty()) {
+			unsigned const current = pending.back();
+			pending.pop_back();
+			if (current == to) {
+				std::vector<edge const*> path;
+				for (unsigned at = to; at != from; at = reached_from[at].first) {
+					path.insert(path.begin(), reached_from[at].second);
+				}
+				return path;
+			}
+			auto const out = graph.find(current);
+			if (out == graph.end()) {
+				continue;
+			}
+			for (auto const& [next, e] : out->second) {
+				if (reached_from.emplace(next, std::make_pair(current, &e)).second) {
+					pending.push_back(next);
+				}
+			}
+		}
+		return {};
+	}
+
+	void add_edge(held_lock const& from, unsigned to, char const* to_name, std::source_location const& to_site) {
+		std::lock_guard<std::mutex> lk(graph_mutex);
+		auto& out = graph[from.id];
+		if (out.contains(to)) {
+			return;
+		}
+		std::vector<edge const*> const path_back = find_path(to, from.id);
+		// the edge goes in even when it closes a cycle, so the same inversion is only reported once
+		out.emplace(to, edge{ from.name, to_name, from.site, to_site });
+		if (path_back.empty()) {
+			return;
+		}
+		++violations;
+		std::println(stderr, "lock order inversion: acquiring \"{}\" while holding \"{}\"", to_name, from.name);
+		print_site("holding", from.name, from.site);
+		print_site("acquiring", to_name, to_site);
+		std::println(stderr, "  but the opposite order was established earlier:");
+		for (edge const* e : path_back) {
+			print_site("holding", e->from_name, e->from_site);
+			print_site("acquired", e->to_name, e->to_site);
+		}
+	}
+
+public:
+	static lock_order_validator& instance() {
+		static lock_order_validator validator;
+		return validator;
+	}
+
+	unsigned register_lock() {
+		return next_id++;
+	}
+
+	// called before blocking on a lock; try_lock never blocks, so it only calls acquired()
+	void before_lock(unsigned id, char const* name, std::source_location const& site) {
+		std::vector<held_lock> const& held = held_by_current_thread();
+		for (held_lock const& h : held) {
+			if (h.id == id) {
+				++violations;
+				std::println(stderr, "recursive locking of \"{}\"", name);
+				print_site("holding", h.name, h.site);
+				print_site("acquiring", name, site);
+				return;
+			}
+		}
+		std::unordered_set<std::uint64_t>& seen = edges_seen_by_current_thread();
+		for (held_lock const& h : held) {
+			if (seen.insert((std::uint64_t(h.id) << 32) | id).second) {
+				add_edge(h, id, name, site);
+			}
+		}
+	}
+
+	void acquired(unsigned id, char const* name, std::source_location const& site) {
+		held_by_current_thread().push_back(held_lock{ id, name, site });
+	}
+
+	// locks may be released in any order
+	void released(unsigned id) {
+		std::vector<held_lock>& held = held_by_current_thread();
+		for (auto it = held.rbegin(); it != held.rend(); ++it) {
+			if (it->id == id) {
+				held.erase(std::next(it).base());
+				return;
+			}
+		}
+	}
+
+	unsigned violation_count() const {
+		return violations.load();
+	}
+};
+
+// Wraps any Lockable. With checking disabled it is the wrapped mutex and nothing else. The
+// acquisition site defaults to the caller of lock(), which for std::lock_guard and friends is
+// inside the standard library; checked_lock_guard records the site of the guard instead.
+template<typename Mutex, bool Checked = LOCK_ORDER_CHECKING>
+class checked_mutex;
+
+template<typename Mutex>
+class checked_mutex<Mutex, false> : public Mutex {
+public:
+	explicit checked_mutex(char const* = "mutex") {}
+
+	void lock(std::source_location = std::source_location::current()) {
+		Mutex::lock();
+	}
+};
+
+template<typename Mutex>
+class checked_mutex<Mutex, true> {
+	Mutex m;
+	unsigned const id;
+	char const* const name;
+public:
+	explicit checked_mutex(char const* name_ = "mutex") : id(lock_order_validator::instance().register_lock()), name(name_) {}
+
+	checked_mutex(checked_mutex const&) = delete;
+	checked_mutex& operator=(checked_mutex const&) = delete;
+
+	void lock(std::source_location site = std::source_location::current()) {
+		lock_order_validator::instance().before_lock(id, name, site);
+		m.lock();
+		lock_order_validator::instance().acquired(id, name, site);
+	}
+
+	bool try_lock(std::source_location site = std::source_location::current()) {
+		if (!m.try_lock()) {
+			return false;
+		}
+		lock_order_validator::instance().acquired(id, name, site);
+		return true;
+	}
+
+	void unlock() {
+		lock_order_validator::instance().released(id);
+		m.unlock();
+	}
+};
+
+template<typename Mutex>
+class checked_lock_guard {
+	Mutex& m;
+public:
+	explicit checked_lock_guard(Mutex& m_, std::source_location site = std::source_location::current()) : m(m_) {
+		m.lock(site);
+	}
+
+	~checked_lock_guard() {
+		m.unlock();
+	}
+
+	checked_lock_guard(checked_lock_guard const&) = delete;
+	checked_lock_guard& operator=(checked_lock_guard const&) = delete;
+};
+
+// Listing 4.5 with the mutex as a parameter; condition_variable_any so any Lockable works
+template<typename T, typename Mutex>
+class threadsafe_queue {
+private:
+	mutable Mutex mut;
+	std::queue<T> data_queue;
+	std::condition_variable_any data_cond;
+public:
+	threadsafe_queue() {}
+
+	void push(T new_value) {
+		std::lock_guard<Mutex> lk(mut);
+		data_queue.push(new_value);
+		data_cond.notify_one();
+	}
+
+	void wait_and_pop(T& value) {
+		std::unique_lock<Mutex> lk(mut);
+		data_cond.wait(lk, [this] {return !data_queue.empty(); });
+		value = data_queue.front();
+		data_queue.pop();
+	}
+};
+
+template<typename Mutex>
+struct account {
+	Mutex m;
+	long balance = 1000;
+};
+
+// random transfers between accounts, each locking both sides as in Listing 3.6
+template<typename Mutex>
+void run_bank_benchmark(std::string const& name) {
+	const int num_accounts = 64;
+	const int num_threads = 4;
+	const int transfers_per_thread = 250000;
+	std::vector<account<Mutex>> accounts(num_accounts);
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&accounts, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int> dist(0, num_accounts - 1);
+			for (int i = 0; i < transfers_per_thread; ++i) {
+				account<Mutex>& from = accounts[dist(gen)];
+				account<Mutex>& to = accounts[dist(gen)];
+				if (&from == &to) {
+					continue;
+				}
+				std::scoped_lock lk(from.m, to.m);
+				from.balance -= 1;
+				to.balance += 1;
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	long total = 0;
+	for (auto& a : accounts) {
+		total += a.balance;
+	}
+	assert(total == 1000L * num_accounts);
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("bank  {:<28} {:>6.1f} ns/transfer", name, duration.count() / (double(num_threads) * transfers_per_thread));
+}
+
+template<typename Mutex>
+void run_queue_benchmark(std::string const& name) {
+	const int num_pairs = 2;
+	const int items_per_producer = 250000;
+	threadsafe_queue<int, Mutex> queue;
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int p = 0; p < num_pairs; ++p) {
+		threads.emplace_back([&queue]() {
+			for (int i = 0; i < items_per_producer; ++i) {
+				queue.push(i);
+			}
+			});
+		threads.emplace_back([&queue]() {
+			int value;
+			for (int i = 0; i < items_per_producer; ++i) {
+				queue.wait_and_pop(value);
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("queue {:<28} {:>6.1f} ns/item", name, duration.count() / (double(num_pairs) * items_per_producer));
+}
+
+int main() {
+	lock_order_validator& validator = lock_order_validator::instance();
+	checked_mutex<std::mutex, true> a("a");
+	checked_mutex<std::mutex, true> b("b");
+	checked_mutex<std::mutex, true> c("c");
+
+	// the same nesting from several threads is fine, and so is scoped_lock in either order,
+	// since std::lock only blocks while holding nothing and try_locks the rest
+	{
+		std::vector<std::jthread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([&]() {
+				checked_lock_guard lk_a(a);
+				checked_lock_guard lk_b(b);
+				});
+			threads.emplace_back([&]() {
+				checked_lock_guard lk_b(b);
+				checked_lock_guard lk_c(c);
+				});
+			threads.emplace_back([&]() {
+				std::scoped_lock lk(b, c);
+				});
+			threads.emplace_back([&]() {
+				std::scoped_lock lk(c, b);
+				});
+		}
+	}
+	assert(validator.violation_count() == 0);
+
+	// b -> a inverts the a -> b learned above, although no deadlock happens this time
+	std::jthread([&]() {
+		checked_lock_guard lk_b(b);
+		checked_lock_guard lk_a(a);
+		}).join();
+	assert(validator.violation_count() == 1);
+
+	// c -> a closes the longer cycle a -> b -> c -> a, made of edges learned by other threads
+	std::jthread([&]() {
+		checked_lock_guard lk_c(c);
+		checked_lock_guard lk_a(a);
+		}).join();
+	assert(validator.violation_count() == 2);
+
+	// a successful try_lock is recorded as held, but adds no edges since it never blocks
+	{
+		checked_lock_guard lk_c(c);
+		assert(b.try_lock());
+		b.unlock();
+	}
+	assert(validator.violation_count() == 2);
+	std::println("Test passed!");
+
+	run_bank_benchmark<std::mutex>("std::mutex");
+	run_bank_benchmark<checked_mutex<std::mutex, false>>("checked_mutex, disabled");
+	run_bank_benchmark<checked_mutex<std::mutex, true>>("checked_mutex, enabled");
+	run_queue_benchmark<std::mutex>("std::mutex");
+	run_queue_benchmark<checked_mutex<std::mutex, false>>("checked_mutex, disabled");
+	run_queue_benchmark<checked_mutex<std::mutex, true>>("checked_mutex, enabled");
+	return 0;
+}
@@ -0,0 +1,724 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <queue>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// a string literal usable as a template argument, so a lock's name is part of its type
+template<std::size_t N>
+struct lock_name {
+	char value[N];
+	constexpr lock_name(char const (&name)[N]) {
+		std::copy_n(name, N, value);
+	}
+};
+
+// Collects lock statistics per lock name. Every instance with the same name counts towards
+// the same entry, so for example all bucket locks of a hash table show up as one line. Each
+// thread records into its own buffer, which is merged into the totals when the thread exits,
+// so recording never touches memory shared with other threads. The report of the locks with
+// the most waiting is printed at program exit.
+class lock_profiler {
+public:
+	typedef std::chrono::steady_clock clock;
+	static constexpr std::size_t histogram_buckets = 40; // bucket b counts times below 2^b ns
+	static constexpr std::size_t report_size = 10;
+
+	struct lock_stats {
+		std::uint64_t acquisitions = 0;
+		std::uint64_t contended = 0;
+		std::uint64_t total_wait_ns = 0;
+		std::uint64_t total_hold_ns = 0;
+		std::uint64_t wait_histogram[histogram_buckets] = {};
+		std::uint64_t hold_histogram[histogram_buckets] = {};
+
+		static void add_to_histogram(std::uint64_t (&histogram)[histogram_buckets], std::uint64_t ns) {
+			++histogram[std::min<std::size_t>(std::bit_width(ns), histogram_buckets - 1)];
+		}
+
+		void merge(lock_stats const& other) {
+			acquisitions += other.acquisitions;
+			contended += other.contended;
+			total_wait_ns += other.total_wait_ns;
+			total_hold_ns += other.total_hold_ns;
+			for (std::size_t b = 0; b < histogram_buckets; ++b) {
+				wait_histogram[b] += other.wait_histogram[b];
+				hold_histogram[b] += other.hold_histogram[b];
+			}
+		}
+	};
+
+private:
+	struct thread_buffer {
+		std::vector<lock_stats> stats;
+
+		thread_buffer() {
+			instance(); // constructed first, so it is still alive when this buffer is merged
+		}
+
+		~thread_buffer() {
+			instance().merge(stats);
+		}
+
+		lock_stats& for_lock(unsigned id) {
+			if (id >= stats.size()) {
+				stats.resize(id + 1);
+			}
+			return stats[id];
+		}
+	};
+
+	std::mutex m;
+	std::vector<std::string> names;
+	std::vector<lock_stats> totals;
+
+	static thread_buffer& buffer_for_current_thread() {
+		thread_local thread_buffer buffer;
+		return buffer;
+	}
+
+	void merge(std::vector<lock_stats> const& stats) {
+		std::lock_guard<std::mutex> lk(m);
+		for (std::size_t id = 0; id < stats.size(); ++id) {
+			totals[id].merge(stats[id]);
+		}
+	}
+
+	// upper bound of the bucket holding the given fraction of the samples
+	static std::uint64_t percentile(std::uint64_t const (&histogram)[histogram_buckets], double fraction) {
+		std::uint64_t total = 0;
+		for (std::uint64_t count : histogram) {
+			total += count;
+		}
+		std::uint64_t const wanted = std::uint64_t(fraction * double(total));
+		std::uint64_t seen = 0;
+		for (std::size_t b = 0; b < histogram_buckets; ++b) {
+			seen += histogram[b];
+			if (seen > wanted) {
+				return std::uint64_t(1) << b;
+			}
+		}
+		return std::uint64_t(1) << (histogram_buckets - 1);
+	}
+
+	static std::string format_ns(double ns) {
+		if (ns >= 1e9) {
+			return std::to_string(std::uint64_t(ns / 1e6)) + " ms";
+		}
+		if (ns >= 1e6) {
+			return std::to_string(std::uint64_t(ns / 1e3)) + " us";
+		}
+		return std::to_string(std::uint64_t(ns)) + " ns";
+	}
+
+	lock_profiler() {}
+
+public:
+	static lock_profiler& instance() {
+		static lock_profiler profiler;
+		return profiler;
+	}
+
+	~lock_profiler() {
+		report(report_size);
+	}
+
+	unsigned register_lock(std::string name) {
+		std::lock_guard<std::mutex> lk(m);
+		names.push_back(std::move(name));
+		totals.emplace_back();
+		return unsigned(names.size() - 1);
+	}
+
+	static void record_acquisition(unsigned id, clock::duration wait, bool contended) {
+		lock_stats& stats = buffer_for_current_thread().for_lock(id);
+		std::uint64_t const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+		++stats.acquisitions;
+		stats.contended += contended;
+		stats.total_wait_ns += ns;
+		lock_stats::add_to_histogram(stats.wait_histogram, ns);
+	}
+
+	static void record_release(unsigned id, clock::duration hold) {
+		lock_stats& stats = buffer_for_current_thread().for_lock(id);
+		std::uint64_t const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(hold).count();
+		stats.total_hold_ns += ns;
+		lock_stats::add_to_histogram(stats.hold_histogram, ns);
+	}
+
+	// merged statistics of every lock with this name, from threads that have already exited
+	lock_stats totals_for(std::string const& name) {
+		std::lock_guard<std::mutex> lk(m);
+		lock_stats result;
+		for (std::size_t id = 0; id < names.size(); ++id) {
+			if (names[id] == name) {
+				result.merge(totals[id]);
+			}
+		}
+		return result;
+	}
+
+	// covers threads that have already exited
+	void report(std::size_t top_n) {
+		std::lock_guard<std::mutex> lk(m);
+		std::vector<unsigned> order;
+		for (unsigned id = 0; id < totals.size(); ++id) {
+			if (totals[id].acquisitions > 0) {
+				order.push_back(id);
+			}
+		}
+		if (order.empty()) {
+			return;
+		}
+		std::sort(order.begin(), order.end(), [this](unsigned lhs, unsigned rhs) {
+			return totals[lhs].total_wait_ns > totals[rhs].total_wait_ns;
+			});
+		order.resize(std::min(order.size(), top_n));
+		std::println("Lock contention, top {} by total wait:", order.size());
+		std::println("{:<40} {:>12} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}",
+			"lock", "acquisitions", "contended", "total wait", "wait p50", "wait p99", "total hold", "hold p99");
+		for (unsigned const id : order) {
+			lock_stats const& s = totals[id];
+			std::println("{:<40} {:>12} {:>9.2f}% {:>10} {:>10} {:>10} {:>10} {:>10}",
+				names[id], s.acquisitions, 100.0 * double(s.contended) / double(s.acquisitions),
+				format_ns(double(s.total_wait_ns)), format_ns(double(percentile(s.wait_histogram, 0.5))),
+				format_ns(double(percentile(s.wait_histogram, 0.99))), format_ns(double(s.total_hold_ns)),
+				format_ns(double(percentile(s.hold_histogram, 0.99))));
+		}
+	}
+};
+
+// Wraps any Lockable. An acquisition counts as contended when try_lock fails first; only then
+// is the wait timed, which saves a clock read on the fast path. The hold time runs until unlock.
+template<typename Mutex, lock_name Name>
+class instrumented_mutex {
+	Mutex m;
+	lock_profiler::clock::time_point acquired_at; // only touched by the holder
+
+	static unsigned id() {
+		static unsigned const lock_id = lock_profiler::instance().register_lock(Name.value);
+		return lock_id;
+	}
+
+public:
+	instrumented_mutex() {}
+
+	instrumented_mutex(instrumented_mutex const&) = delete;
+	instrumented_mutex& operator=(instrumented_mutex const&) = delete;
+
+	void lock() {
+		if (m.try_lock()) {
+			acquired_at = lock_profiler::clock::now();
+			lock_profiler::record_acquisition(id(), lock_profiler::clock::duration::zero(), false);
+			return;
+		}
+		auto const start = lock_profiler::clock::now();
+		m.lock();
+		acquired_at = lock_profiler::clock::now();
+		lock_profiler::record_acquisition(id(), acquired_at - start, true);
+	}
+
+	bool try_lock() {
+		if (!m.try_lock()) {
+			return false;
+		}
+		acquired_at = lock_profiler::clock::now();
+		lock_profiler::record_acquisition(id(), lock_profiler::clock::duration::zero(), false);
+		return true;
+	}
+
+	void unlock() {
+		auto const held = lock_profiler::clock::now() - acquired_at;
+		m.unlock();
+		lock_profiler::record_release(id(), held);
+	}
+};
+
+// Exclusive and shared acquisitions are reported as two entries. Shared holders can overlap,
+// so each thread remembers when it took its shared locks.
+template<typename SharedMutex, lock_name Name>
+class instrumented_shared_mutex {
+	SharedMutex m;
+	lock_profiler::clock::time_point acquired_at;
+
+	struct shared_hold {
+		instrumented_shared_mutex const* mutex;
+		lock_profiler::clock::time_point since;
+	};
+
+	static std::vector<shared_hold>& shared_holds_of_current_thread() {
+		thread_local std::vector<shared_hold> holds;
+		return holds;
+	}
+
+	static unsigned exclusive_id() {
+		static unsigned const lock_id = lock_profiler::instance().register_lock(Name.value);
+		return lock_id;
+	}
+
+	static unsigned shared_id() {
+		static unsigned const lock_id = lock_profiler::instance().register_lock(std::string(Name.value) + " (shared)");
+		return lock_id;
+	}
+
+	void acquired_shared(lock_profiler::clock::duration wait, bool contended) {
+		auto const now = lock_profiler::clock::now();
+		shared_holds_of_current_thread().push_back(shared_hold{ this, now });
+		lock_profiler::record_acquisition(shared_id(), wait, contended);
+	}
+
+public:
+	instrumented_shared_mutex() {}
+
+	instrumented_shared_mutex(instrumented_shared_mutex const&) = delete;
+	instrumented_shared_mutex& operator=(instrumented_shared_mutex const&) = delete;
+
+	void lock() {
+		if (m.try_lock()) {
+			acquired_at = lock_profiler::clock::now();
+			lock_profiler::record_acquisition(exclusive_id(), lock_profiler::clock::duration::zero(), false);
+			return;
+		}
+		auto const start = lock_profiler::clock::now();
+		m.lock();
+		acquired_at = lock_profiler::clock::now();
+		lock_profiler::record_acquisition(exclusive_id(), acquired_at - start, true);
+	}
+
+	bool try_lock() {
+		if (!m.try_lock()) {
+			return false;
+		}
+		acquired_at = lock_profiler::clock::now();
+		lock_profiler::record_acquisition(exclusive_id(), lock_profiler::clock::duration::zero(), false);
+		return true;
+	}
+
+	void unlock() {
+		auto const held = lock_profiler::clock::now() - acquired_at;
+		m.unlock();
+		lock_profiler::record_release(exclusive_id(), held);
+	}
+
+	void lock_shared() {
+		if (m.try_lock_shared()) {
+			acquired_shared(lock_profiler::clock::duration::zero(), false);
+			return;
+		}
+		auto const start = lock_profiler::clock::now();
+		m.lock_shared();
+		acquired_shared(lock_profiler::clock::now() - start, true);
+	}
+
+	bool try_lock_shared() {
+		if (!m.try_lock_shared()) {
+			return false;
+		}
+		acquired_shared(lock_profiler::clock::duration::zero(), false);
+		return true;
+	}
+
+	void unlock_shared() {
+		std::vector<shared_hold>& holds = shared_holds_of_current_thread();
+		auto const hold = std::find_if(holds.rbegin(), holds.rend(), [this](shared_hold const& h) { return h.mutex == this; });
+		assert(hold != holds.rend());
+		auto const held = lock_profiler::clock::now() - hold->since;
+		holds.erase(std::next(hold).base());
+		m.unlock_shared();
+		lock_profiler::record_release(shared_id(), held);
+	}
+};
+
+// Listing 4.5 with the mutex as a parameter; condition_variable_any works with any Lockable
+template<typename T, typename Mutex = std::mutex>
+class threadsafe_queue {
+private:
+	mutable Mutex mut;
+	std::queue<T> data_queue;
+	std::condition_variable_any data_cond;
+public:
+	threadsafe_queue() {}
+
+	void push(T new_value) {
+		std::lock_guard<Mutex> lk(mut);
+		data_queue.push(new_value);
+		data_cond.notify_one();
+	}
+
+	void wait_and_pop(T& value) {
+		std::unique_lock<Mutex> lk(mut);
+		data_cond.wait(lk, [this] {return !data_queue.empty(); });
+		value = data_queue.front();
+		data_queue.pop();
+	}
+
+	bool try_pop(T& value) {
+		std::lock_guard<Mutex> lk(mut);
+		if (data_queue.empty())
+			return false;
+		value = data_queue.front();
+		data_queue.pop();
+		return true;
+	}
+};
+
+// Listing 6.11 with the bucket lock as a parameter
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename SharedMutex = std::shared_mutex>
+class threadsafe_lookup_table {
+private:
+	class bucket_type {
+	private:
+		typedef std::pair<Key, Value> bucket_value;
+		typedef std::list<bucket_value> bucket_data;
+		typedef typename bucket_data::iterator bucket_iterator;
+		bucket_data data;
+		mutable SharedMutex mutex;
+
+		bucket_iterator find_entry_for(Key const& key) {
+			return std::find_if(data.begin(), data.end(), [&](bucket_value const& item) { return item.first == key; });
+		}
+	public:
+		Value value_for(Key const& key, Value const& default_value) {
+			std::shared_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			return (found_entry == data.end()) ? default_value : found_entry->second;
+		}
+
+		void add_or_update_mapping(Key const& key, Value const& value) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry == data.end()) {
+				data.push_back(bucket_value(key, value));
+			}
+			else {
+				found_entry->second = value;
+			}
+		}
+
+		void remove_mapping(Key const& key) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry != data.end()) {
+				data.erase(found_entry);
+			}
+		}
+	};
+
+	std::vector<std::unique_ptr<bucket_type>> buckets;
+	Hash hasher;
+
+	bucket_type& get_bucket(Key const& key) const {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		return *buckets[bucket_index];
+	}
+public:
+	threadsafe_lookup_table(unsigned num_buckets = 19, Hash const& hasher_ = Hash()) : buckets(num_buckets), hasher(hasher_) {
+		for (unsigned i = 0; i < num_buckets; ++i) {
+			buckets[i].reset(new bucket_type);
+		}
+	}
+
+	threadsafe_lookup_table(threadsafe_lookup_table const& other) = delete;
+	threadsafe_lookup_table& operator=(threadsafe_lookup_table const& other) = delete;
+
+	Value value_for(Key const& key, Value const& default_value = Value()) const {
+		return get_bucket(key).value_for(key, default_value);
+	}
+
+	void add_or_update_mapping(Key const& key, Value const& value) {
+		get_bucket(key).add_or_update_mapping(key, value);
+	}
+
+	void remove_mapping(Key const& key) {
+		get_bucket(key).remove_mapping(key);
+	}
+};
+
+// Listing 6.13 with the node lock as a parameter
+template<typename T, typename Mutex = std::mutex>
+class threadsafe_list {
+	struct node {
+		Mutex m;
+		std::shared_ptr<T> data;
+		std::unique_ptr<node> next;
+		node() : next() {}
+		node(T const& value) : data(std::make_shared<T>(value)) {}
+	};
+	node head;
+public:
+	threadsafe_list() {}
+
+	~threadsafe_list() {
+		remove_if([](T const&) {return true; });
+	}
+
+	threadsafe_list(threadsafe_list const& other) = delete;
+
+	threadsafe_list& operator=(threadsafe_list const& other) = delete;
+
+	void push_front(T const& value) {
+		std::unique_ptr<node> new_node(new node(value));
+		std::lock_guard<Mutex> lk(head.m);
+		new_node->next = std::move(head.next);
+		head.next = std::move(new_node);
+	}
+
+	template<typename Function> requires std::invocable<Function, T&>
+	void for_each(Function f) {
+		node* current = &head;
+		std::unique_lock<Mutex> lk(head.m);
+		while (node* const next = current->next.get())
+		{
+			std::unique_lock<Mutex> next_lk(next->m);
+			lk.unlock();
+			f(*next->data);
+			current = next;
+			lk = std::move(next_lk);
+		}
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<Mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<Mutex> next_lk(next->m);
+			if (p(*next->data)) {
+				std::unique_ptr<node> old_next = std::move(current->next);
+				current->next = std::move(next->next);
+				next_lk.unlock();
+			}
+			else {
+				lk.unlock();
+				current = next;
+				lk = std::move(next_lk);
+			}
+		}
+	}
+};
+
+// the message queue from the ATM example in 4/15, with the mutex as a parameter
+namespace messaging {
+	struct message_base
+	{
+		virtual ~message_base() {}
+	};
+
+	template<typename Msg>
+	struct wrapped_message : message_base {
+		Msg contents;
+		explicit wrapped_message(Msg const& contents_) : contents(contents_) {}
+	};
+
+	template<typename Mutex = std::mutex>
+	class queue {
+		Mutex m;
+		std::condition_variable_any c;
+		std::queue<std::shared_ptr<message_base>> q;
+	public:
+		template<typename T>
+		void push(T const& msg) {
+			std::lock_guard<Mutex> lk(m);
+			q.push(std::make_shared<wrapped_message<T>>(msg));
+			c.notify_all();
+		}
+
+		std::shared_ptr<message_base> wait_and_pop() {
+			std::unique_lock<Mutex> lk(m);
+			c.wait(lk, [&] { return !q.empty(); });
+			auto res = q.front();
+			q.pop();
+			return res;
+		}
+	};
+}
+
+struct withdraw {
+	unsigned amount;
+};
+
+// drives all four containers at once: queue producers and consumers, lookup table readers and
+// writers, a list that is scanned while it grows and is pruned, and a message queue pair
+template<typename QueueMutex, typename TableMutex, typename ListMutex, typename MessageMutex>
+std::chrono::duration<double, std::milli> run_workload() {
+	const int items = 100000;
+	threadsafe_queue<int, QueueMutex> work_queue;
+	threadsafe_lookup_table<int, int, std::hash<int>, TableMutex> table;
+	threadsafe_list<int, ListMutex> list;
+	messaging::queue<MessageMutex> messages;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<std::jthread> threads;
+		for (int p = 0; p < 2; ++p) {
+			threads.emplace_back([&work_queue]() {
+				for (int i = 0; i < items; ++i) {
+					work_queue.push(i);
+				}
+				});
+			threads.emplace_back([&work_queue, &table]() {
+				int value;
+				for (int i = 0; i < items; ++i) {
+					work_queue.wait_and_pop(value);
+					table.add_or_update_mapping(value % 1000, value);
+				}
+				});
+		}
+		for (int r = 0; r < 2; ++r) {
+			threads.emplace_back([&table]() {
+				long long sum = 0;
+				for (int i = 0; i < 4 * items; ++i) {
+					sum += table.value_for(i % 1000, 0);
+				}
+				assert(sum >= 0);
+				(void)sum;
+				});
+		}
+		threads.emplace_back([&list]() {
+			for (int i = 0; i < items / 10; ++i) {
+				list.push_front(i);
+				if (i % 1000 == 999) {
+					list.remove_if([](int const& value) { return value % 2 == 0; });
+				}
+			}
+			});
+		threads.emplace_back([&list]() {
+			for (int i = 0; i < 20; ++i) {
+				int count = 0;
+				list.for_each([&count](int&) { ++count; });
+			}
+			});
+		threads.emplace_back([&messages]() {
+			for (int i = 0; i < items; ++i) {
+				messages.push(withdraw{ 50 });
+			}
+			});
+		threads.emplace_back([&messages]() {
+			unsigned total = 0;
+			for (int i = 0; i < items; ++i) {
+				auto const msg = messages.wait_and_pop();
+				total += static_cast<messaging::wrapped_message<withdraw>*>(msg.get())->contents.amount;
+			}
+			assert(total == 50u * items);
+			(void)total;
+			});
+	}
+	return std::chrono::high_resolution_clock::now() - start;
+}
+
+// std::mutex that counts failed try_locks, so a test can tell when a waiter is about to block
+struct observable_mutex {
+	static inline std::atomic<int> failed_try_locks{ 0 };
+	std::mutex m;
+
+	void lock() {
+		m.lock();
+	}
+
+	bool try_lock() {
+		if (m.try_lock()) {
+			return true;
+		}
+		failed_try_locks.fetch_add(1);
+		return false;
+	}
+
+	void unlock() {
+		m.unlock();
+	}
+};
+
+std::uint64_t samples_in(std::uint64_t const (&histogram)[lock_profiler::histogram_buckets]) {
+	std::uint64_t total = 0;
+	for (std::uint64_t count : histogram) {
+		total += count;
+	}
+	return total;
+}
+
+// The holder takes the lock uncontended a number of times, then for each round holds it until
+// the waiter's try_lock has failed, so the waiter's acquisition is contended every time.
+void test_profiler_counts() {
+	const int uncontended = 100;
+	const int rounds = 3;
+	instrumented_mutex<observable_mutex, "profiler test"> m;
+	std::atomic<int> holder_round{ 0 };
+	std::atomic<int> waiter_round{ 0 };
+
+	std::thread holder([&]() {
+		for (int i = 0; i < uncontended; ++i) {
+			std::lock_guard<decltype(m)> lk(m);
+		}
+		for (int r = 1; r <= rounds; ++r) {
+			m.lock();
+			holder_round.store(r);
+			while (observable_mutex::failed_try_locks.load() < r) {
+				std::this_thread::yield();
+			}
+			m.unlock();
+			while (waiter_round.load() < r) {
+				std::this_thread::yield();
+			}
+		}
+		});
+	std::thread waiter([&]() {
+		for (int r = 1; r <= rounds; ++r) {
+			while (holder_round.load() < r) {
+				std::this_thread::yield();
+			}
+			m.lock();
+			m.unlock();
+			waiter_round.store(r);
+		}
+		});
+	holder.join();
+	waiter.join();
+
+	lock_profiler::lock_stats const stats = lock_profiler::instance().totals_for("profiler test");
+	assert(stats.acquisitions == uncontended + 2 * rounds);
+	assert(stats.contended == rounds);
+	assert(samples_in(stats.wait_histogram) == stats.acquisitions);
+	assert(samples_in(stats.hold_histogram) == stats.acquisitions);
+	assert(stats.total_wait_ns > 0);
+	(void)stats;
+}
+
+int main() {
+	test_profiler_counts();
+	{
+		instrumented_mutex<std::mutex, "test mutex"> m;
+		instrumented_shared_mutex<std::shared_mutex, "test shared_mutex"> sm;
+		std::lock_guard<instrumented_mutex<std::mutex, "test mutex">> lk(m);
+		assert(!m.try_lock());
+		std::shared_lock<instrumented_shared_mutex<std::shared_mutex, "test shared_mutex">> slk(sm);
+		assert(sm.try_lock_shared());
+		sm.unlock_shared();
+		assert(!sm.try_lock());
+	}
+	std::println("Test passed!");
+
+	auto const plain = run_workload<std::mutex, std::shared_mutex, std::mutex, std::mutex>();
+	auto const instrumented = run_workload<
+		instrumented_mutex<std::mutex, "threadsafe_queue">,
+		instrumented_shared_mutex<std::shared_mutex, "threadsafe_lookup_table bucket">,
+		instrumented_mutex<std::mutex, "threadsafe_list node">,
+		instrumented_mutex<std::mutex, "messaging::queue">>();
+	std::println("Workload with plain locks:        {:.1f} ms", plain.count());
+	std::println("Workload with instrumented locks: {:.1f} ms", instrumented.count());
+	return 0;
+}
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <print>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Word-based software transactional memory after TL2 (Dice, Shalev, Shavit). Each shared word
+// carries a versioned lock: bit 0 is the lock, the rest is the global clock value of the last
+// commit that wrote it. A transaction reads the clock when it starts and only accepts words
+// that are unlocked and no newer than that, buffering its writes. At commit it locks just the
+// words it writes, takes a new clock value, revalidates what it read and publishes. Two
+// transactions only get in each other's way if they touch a common word.
+struct transaction_aborted : std::exception {
+	const char* what() const noexcept override {
+		return "transaction aborted";
+	}
+};
+
+std::atomic<std::uint64_t> global_version_clock{ 0 };
+
+class tm_word {
+	friend class transaction;
+	std::atomic<std::uint64_t> versioned_lock{ 0 };
+	std::atomic<std::uint64_t> value;
+public:
+	explicit tm_word(std::uint64_t value_ = 0) : value(value_) {}
+
+	tm_word(tm_word const&) = delete;
+	tm_word& operator=(tm_word const&) = delete;
+};
+
+// Transactions don't nest: the read and write sets are per-thread buffers reused from one
+// transaction to the next, so starting one allocates nothing.
+class transaction {
+	struct access_sets {
+		std::vector<tm_word const*> reads;
+		std::vector<std::pair<tm_word*, std::uint64_t>> writes;
+	};
+
+	static access_sets& sets_for_current_thread() {
+		thread_local access_sets sets;
+		return sets;
+	}
+
+	std::uint64_t read_version;
+	std::vector<tm_word const*>& read_set;
+	std::vector<std::pair<tm_word*, std::uint64_t>>& write_set;
+
+	static bool is_locked(std::uint64_t versioned_lock) {
+		return versioned_lock & 1;
+	}
+
+	bool writes_to(tm_word const* word) const {
+		return std::any_of(write_set.begin(), write_set.end(), [word](auto const& w) { return w.first == word; });
+	}
+
+	void unlock_write_set(std::size_t count) {
+		for (std::size_t i = 0; i < count; ++i) {
+			write_set[i].first->versioned_lock.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+public:
+	transaction() : read_version(global_version_clock.load(std::memory_order_acquire)),
+		read_set(sets_for_current_thread().reads), write_set(sets_for_current_thread().writes) {
+		read_set.clear();
+		write_set.clear();
+	}
+
+	transaction(transaction const&) = delete;
+	transaction& operator=(transaction const&) = delete;
+
+	std::uint64_t read(tm_word const& word) {
+		for (auto const& [written, value] : write_set) {
+			if (written == &word) {
+				return value;
+			}
+		}
+		std::uint64_t const before = word.versioned_lock.load(std::memory_order_acquire);
+		std::uint64_t const value = word.value.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		std::uint64_t const after = word.versioned_lock.load(std::memory_order_relaxed);
+		if (is_locked(before) || before != after || before > read_version) {
+			throw transaction_aborted();
+		}
+		read_set.push_back(&word);
+		return value;
+	}
+
+	void write(tm_word& word, std::uint64_t value) {
+		for (auto& [written, buffered] : write_set) {
+			if (written == &word) {
+				buffered = value;
+				return;
+			}
+		}
+		write_set.emplace_back(&word, value);
+	}
+
+	// read-only transactions were already validated word by word and need nothing here
+	bool commit() {
+		if (write_set.empty()) {
+			return true;
+		}
+		// a fixed order means two committers can't each hold a lock the other is waiting for
+		std::sort(write_set.begin(), write_set.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+		for (std::size_t i = 0; i < write_set.size(); ++i) {
+			std::atomic<std::uint64_t>& lock = write_set[i].first->versioned_lock;
+			std::uint64_t current = lock.load(std::memory_order_relaxed);
+			if (is_locked(current) || !lock.compare_exchange_strong(current, current | 1, std::memory_order_acquire)) {
+				unlock_write_set(i);
+				return false;
+			}
+		}
+		std::uint64_t const write_version = global_version_clock.fetch_add(2, std::memory_order_acq_rel) + 2;
+		// if nobody committed since we started, nothing we read can have changed
+		if (write_version != read_version + 2) {
+			for (tm_word const* word : read_set) {
+				std::uint64_t const current = word->versioned_lock.load(std::memory_order_acquire);
+				if ((current & ~std::uint64_t(1)) > read_version || (is_locked(current) && !writes_to(word))) {
+					unlock_write_set(write_set.size());
+					return false;
+				}
+			}
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		for (auto const& [word, value] : write_set) {
+			word->value.store(value, std::memory_order_relaxed);
+		}
+		for (auto const& [word, value] : write_set) {
+			word->versioned_lock.store(write_version, std::memory_order_release);
+		}
+		return true;
+	}
+};
+
+// runs f(tx) until it commits; f may run several times, so it should only change tm_words
+template<typename Function>
+auto atomically(Function f) {
+	unsigned attempts = 0;
+	while (true) {
+		try {
+			transaction tx;
+			if constexpr (std::is_void_v<decltype(f(tx))>) {
+				f(tx);
+				if (tx.commit()) {
+					return;
+				}
+			}
+			else {
+				auto result = f(tx);
+				if (tx.commit()) {
+					return result;
+				}
+			}
+		}
+		catch (transaction_aborted const&) {}
+		if (++attempts > 4) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+// a typed view of a tm_word for small trivially copyable values
+template<typename T> requires std::is_trivially_copyable_v<T> && (sizeof(T) <= sizeof(std::uint64_t))
+class tvar {
+	tm_word word;
+
+	static std::uint64_t to_word(T const& value) {
+		std::uint64_t bits = 0;
+		std::memcpy(&bits, &value, sizeof(T));
+		return bits;
+	}
+public:
+	explicit tvar(T const& value = T()) : word(to_word(value)) {}
+
+	T get(transaction& tx) const {
+		std::uint64_t const bits = tx.read(word);
+		T value;
+		std::memcpy(&value, &bits, sizeof(T));
+		return value;
+	}
+
+	void set(transaction& tx, T const& value) {
+		tx.write(word, to_word(value));
+	}
+};
+
+// the X from Listings 3.6 and 3.9, with the detail held transactionally
+class X {
+private:
+	tvar<long> some_detail;
+public:
+	X(long sd) : some_detail(sd) {}
+
+	long get_detail(transaction& tx) const {
+		return some_detail.get(tx);
+	}
+
+	long get_detail() const {
+		return atomically([this](transaction& tx) { return get_detail(tx); });
+	}
+
+	friend void swap(X& lhs, X& rhs) {
+		if (&lhs == &rhs)
+			return;
+		atomically([&](transaction& tx) {
+			long const lhs_value = lhs.some_detail.get(tx);
+			lhs.some_detail.set(tx, rhs.some_detail.get(tx));
+			rhs.some_detail.set(tx, lhs_value);
+			});
+	}
+};
+
+struct locked_account {
+	std::mutex m;
+	long balance = 1000;
+};
+
+struct tm_account {
+	tvar<long> balance{ 1000 };
+};
+
+// N distinct accounts
+template<std::size_t N>
+std::array<int, N> pick_accounts(std::mt19937& gen, int num_accounts) {
+	std::uniform_int_distribution<int> dist(0, num_accounts - 1);
+	std::array<int, N> picked;
+	for (std::size_t i = 0; i < N; ++i) {
+		do {
+			picked[i] = dist(gen);
+		} while (std::find(picked.begin(), picked.begin() + i, picked[i]) != picked.begin() + i);
+	}
+	return picked;
+}
+
+// every transfer moves one unit from each of N - 1 accounts into the first; the total is fixed
+template<std::size_t N>
+void run_locked_benchmark(int num_accounts, int num_threads) {
+	const int transfers_per_thread = 100000;
+	std::vector<locked_account> accounts(num_accounts);
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&accounts, num_accounts, t]() {
+			std::mt19937 gen(t);
+			for (int i = 0; i < transfers_per_thread; ++i) {
+				std::array<int, N> const picked = pick_accounts<N>(gen, num_accounts);
+				[&]<std::size_t... I>(std::index_sequence<I...>) {
+					std::scoped_lock lk(accounts[picked[I]].m...);
+					((accounts[picked[I]].balance -= (I == 0 ? -long(N - 1) : 1)), ...);
+				}(std::make_index_sequence<N>{});
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	long total = 0;
+	for (auto& a : accounts) {
+		total += a.balance;
+	}
+	assert(total == 1000L * num_accounts);
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("scoped_lock {} objects, {:>4} accounts, {} threads: {:>7.1f} ns/transfer",
+		N, num_accounts, num_threads, duration.count() / (double(num_threads) * transfers_per_thread));
+}
+
+template<std::size_t N>
+void run_tm_benchmark(int num_accounts, int num_threads) {
+	const int transfers_per_thread = 100000;
+	std::vector<tm_account> accounts(num_accounts);
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&accounts, num_accounts, t]() {
+			std::mt19937 gen(t);
+			for (int i = 0; i < transfers_per_thread; ++i) {
+				std::array<int, N> const picked = pick_accounts<N>(gen, num_accounts);
+				atomically([&](transaction& tx) {
+					for (std::size_t j = 0; j < N; ++j) {
+						tvar<long>& balance = accounts[picked[j]].balance;
+						balance.set(tx, balance.get(tx) - (j == 0 ? -long(N - 1) : 1));
+					}
+					});
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	long const total = atomically([&accounts](transaction& tx) {
+		long sum = 0;
+		for (auto& a : accounts) {
+			sum += a.balance.get(tx);
+		}
+		return sum;
+		});
+	assert(total == 1000L * num_accounts);
+	(void)total;
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("STM         {} objects, {:>4} accounts, {} threads: {:>7.1f} ns/transfer",
+		N, num_accounts, num_threads, duration.count() / (double(num_threads) * transfers_per_thread));
+}
+
+template<std::size_t N>
+void run_benchmarks() {
+	for (int num_accounts : { 16, 4096 }) {
+		for (int num_threads : { 1, 8 }) {
+			run_locked_benchmark<N>(num_accounts, num_threads);
+			run_tm_benchmark<N>(num_accounts, num_threads);
+		}
+	}
+}
+
+int main() {
+	X x1(1), x2(2);
+	swap(x1, x2);
+	assert(x1.get_detail() == 2 && x2.get_detail() == 1);
+	{
+		std::vector<std::jthread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([&x1, &x2]() {
+				for (int i = 0; i < 10000; ++i) {
+					swap(x1, x2);
+					long const sum = atomically([&](transaction& tx) { return x1.get_detail(tx) + x2.get_detail(tx); });
+					assert(sum == 3);
+					(void)sum;
+				}
+				});
+		}
+	}
+	assert(x1.get_detail() + x2.get_detail() == 3);
+	std::println("Test passed!");
+
+	run_benchmarks<2>();
+	run_benchmarks<4>();
+	run_benchmarks<8>();
+	return 0;
+}
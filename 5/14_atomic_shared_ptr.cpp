@@ -0,0 +1,280 @@
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <print>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Reference-counted pointer whose control block and value live in one allocation
+template<typename T>
+class counted_ptr {
+	template<typename U> friend class atomic_counted_ptr;
+	template<typename U, typename... Args> friend counted_ptr<U> make_counted(Args&&... args);
+
+	struct control_block {
+		std::atomic<long> count;
+		T value;
+		template<typename... Args>
+		control_block(Args&&... args) : count(1), value(std::forward<Args>(args)...) {}
+	};
+
+	control_block* block;
+
+	// adopts a reference the caller already owns
+	explicit counted_ptr(control_block* block_) : block(block_) {}
+
+	control_block* release() {
+		return std::exchange(block, nullptr);
+	}
+
+public:
+	counted_ptr() : block(nullptr) {}
+
+	counted_ptr(counted_ptr const& other) : block(other.block) {
+		if (block) {
+			block->count.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	counted_ptr(counted_ptr&& other) noexcept : block(other.release()) {}
+
+	counted_ptr& operator=(counted_ptr other) noexcept {
+		std::swap(block, other.block);
+		return *this;
+	}
+
+	~counted_ptr() {
+		if (block && block->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete block;
+		}
+	}
+
+	T* get() const {
+		return block ? &block->value : nullptr;
+	}
+
+	T& operator*() const {
+		return block->value;
+	}
+
+	T* operator->() const {
+		return &block->value;
+	}
+
+	explicit operator bool() const {
+		return block != nullptr;
+	}
+
+	long use_count() const {
+		return block ? block->count.load(std::memory_order_relaxed) : 0;
+	}
+};
+
+template<typename T, typename... Args>
+counted_ptr<T> make_counted(Args&&... args) {
+	return counted_ptr<T>(new typename counted_ptr<T>::control_block(std::forward<Args>(args)...));
+}
+
+// Lock-free atomic counted_ptr using split reference counts, as in the lock-free stack of
+// chapter 7. The atomic word packs the control block pointer with a 16-bit external count
+// in the top bits (user-space pointers fit in 48 bits on x86-64 and AArch64), so a single
+// 64-bit CAS updates both. A load bumps the external count to pin the block, takes an
+// ordinary (internal) reference on it, then hands the external unit back: to the word if
+// it is unchanged, otherwise to the internal count, because whoever swapped the block out
+// folded every outstanding external unit into the internal count when it did.
+template<typename T>
+class atomic_counted_ptr {
+	typedef typename counted_ptr<T>::control_block control_block;
+
+	static constexpr int count_shift = 48;
+	static constexpr std::uint64_t one_external = std::uint64_t(1) << count_shift;
+	static constexpr std::uint64_t pointer_mask = one_external - 1;
+
+	std::atomic<std::uint64_t> word;
+
+	static std::uint64_t pack(control_block* block) {
+		std::uint64_t const bits = reinterpret_cast<std::uintptr_t>(block);
+		assert((bits & ~pointer_mask) == 0);
+		return bits;
+	}
+
+	static control_block* pointer_of(std::uint64_t word) {
+		return reinterpret_cast<control_block*>(word & pointer_mask);
+	}
+
+	// signed, so units handed back to a re-published block simply cancel out
+	static long external_count_of(std::uint64_t word) {
+		return static_cast<std::int16_t>(word >> count_shift);
+	}
+
+	// the word's own reference plus the external units it collected become ordinary references
+	static counted_ptr<T> adopt_swapped_out(std::uint64_t old_word) {
+		control_block* const block = pointer_of(old_word);
+		if (block) {
+			if (long const external = external_count_of(old_word)) {
+				block->count.fetch_add(external, std::memory_order_relaxed);
+			}
+		}
+		return counted_ptr<T>(block);
+	}
+
+public:
+	atomic_counted_ptr() : word(0) {}
+
+	explicit atomic_counted_ptr(counted_ptr<T> desired) : word(pack(desired.release())) {}
+
+	~atomic_counted_ptr() {
+		adopt_swapped_out(word.load());
+	}
+
+	atomic_counted_ptr(atomic_counted_ptr const&) = delete;
+	atomic_counted_ptr& operator=(atomic_counted_ptr const&) = delete;
+
+	static constexpr bool is_always_lock_free = std::atomic<std::uint64_t>::is_always_lock_free;
+
+	counted_ptr<T> load() const {
+		auto& w = const_cast<std::atomic<std::uint64_t>&>(word);
+		std::uint64_t current = w.load();
+		std::uint64_t pinned;
+		do {
+			pinned = current + one_external;
+		} while (!w.compare_exchange_weak(current, pinned));
+		control_block* const block = pointer_of(pinned);
+		if (!block) {
+			current = pinned;
+			while (!w.compare_exchange_weak(current, current - one_external)) {
+				if (pointer_of(current) != nullptr) {
+					return counted_ptr<T>();
+				}
+			}
+			return counted_ptr<T>();
+		}
+		block->count.fetch_add(1, std::memory_order_relaxed);
+		current = pinned;
+		while (true) {
+			if (pointer_of(current) != block) {
+				// swapped out: our external unit was folded into the internal count
+				block->count.fetch_sub(1, std::memory_order_relaxed);
+				break;
+			}
+			if (w.compare_exchange_weak(current, current - one_external)) {
+				break;
+			}
+		}
+		return counted_ptr<T>(block);
+	}
+
+	void store(counted_ptr<T> desired) {
+		exchange(std::move(desired));
+	}
+
+	counted_ptr<T> exchange(counted_ptr<T> desired) {
+		return adopt_swapped_out(word.exchange(pack(desired.release())));
+	}
+
+	// on failure expected is replaced by the current value
+	bool compare_exchange_strong(counted_ptr<T>& expected, counted_ptr<T> desired) {
+		std::uint64_t current = word.load();
+		while (pointer_of(current) == expected.block) {
+			if (word.compare_exchange_weak(current, pack(desired.block))) {
+				desired.release();
+				adopt_swapped_out(current);
+				return true;
+			}
+		}
+		expected = load();
+		return false;
+	}
+};
+
+// The X publish/consume pattern from Listing 5.10, scaled up: a writer keeps publishing new
+// immutable X snapshots while readers take a counted reference to the current one and read it.
+struct X {
+	int i;
+	std::string s;
+};
+
+template<typename AtomicPtr, typename Ptr, typename MakeX>
+void run_benchmark(std::string const& name, int num_readers, MakeX make_x) {
+	const int reads_per_reader = 1000000;
+	AtomicPtr p;
+	p.store(make_x(0));
+
+	std::atomic<bool> readers_done{ false };
+	int versions = 0;
+	std::thread writer([&]() {
+		while (!readers_done.load(std::memory_order_relaxed)) {
+			p.store(make_x(++versions));
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		});
+	std::vector<std::thread> readers;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < num_readers; ++r) {
+		readers.emplace_back([&p]() {
+			int last_seen = 0;
+			for (int i = 0; i < reads_per_reader; ++i) {
+				Ptr const x = p.load();
+				assert(x->s == "hello " + std::to_string(x->i));
+				assert(x->i >= last_seen);
+				last_seen = x->i;
+			}
+			(void)last_seen;
+			});
+	}
+	for (auto& t : readers) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	readers_done.store(true);
+	writer.join();
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("{:<36} {} readers: {:.1f} ns/load, {} versions published",
+		name, num_readers, duration.count() / (double(num_readers) * reads_per_reader), versions);
+}
+
+int main() {
+	atomic_counted_ptr<X> p;
+	assert(!p.load());
+	{
+		std::jthread t1([&p]() {
+			p.store(make_counted<X>(42, "hello"));
+			});
+		std::jthread t2([&p]() {
+			counted_ptr<X> x;
+			while (!(x = p.load())) {
+				std::this_thread::yield();
+			}
+			assert(x->i == 42);
+			assert(x->s == "hello");
+			});
+	}
+
+	counted_ptr<X> first = p.load();
+	assert(first.use_count() == 2);
+	counted_ptr<X> const second = make_counted<X>(7, "seven");
+	counted_ptr<X> stale = make_counted<X>(0, "stale");
+	assert(!p.compare_exchange_strong(stale, second));
+	assert(stale.get() == first.get());
+	assert(p.compare_exchange_strong(stale, second));
+	assert(p.load()->i == 7);
+	counted_ptr<X> const old = p.exchange(counted_ptr<X>());
+	assert(old.get() == second.get());
+	assert(!p.load());
+	assert(first.use_count() == 2); // first and stale
+	static_assert(atomic_counted_ptr<X>::is_always_lock_free);
+	std::println("Test passed!");
+
+	for (int num_readers : { 1, 4 }) {
+		run_benchmark<std::atomic<std::shared_ptr<X>>, std::shared_ptr<X>>("std::atomic<std::shared_ptr<X>>", num_readers,
+			[](int i) { return std::make_shared<X>(i, "hello " + std::to_string(i)); });
+		run_benchmark<atomic_counted_ptr<X>, counted_ptr<X>>("atomic_counted_ptr<X> (split counts)", num_readers,
+			[](int i) { return make_counted<X>(i, "hello " + std::to_string(i)); });
+	}
+	std::println("std::atomic<std::shared_ptr<X>> lock-free: {}", std::atomic<std::shared_ptr<X>>::is_always_lock_free);
+	return 0;
+}
@@ -1,60 +1,249 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <print>
+#include <random>
 #include <shared_mutex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
-template<typename Key, typename Value, typename Hash = std::hash<Key>>
+#include "big_reader_mutex.h"
+
+// wyhash-style string hash: 64x64->128 multiply mixing, three independent lanes for long inputs
+namespace fast_hashing {
+	constexpr std::uint64_t secret[4] = {
+		0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+
+	inline std::uint64_t mum(std::uint64_t a, std::uint64_t b) {
+		unsigned __int128 const r = static_cast<unsigned __int128>(a) * b;
+		return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+	}
+
+	inline std::uint64_t read64(unsigned char const* p) {
+		std::uint64_t v;
+		std::memcpy(&v, p, 8);
+		return v;
+	}
+
+	inline std::uint64_t read32(unsigned char const* p) {
+		std::uint32_t v;
+		std::memcpy(&v, p, 4);
+		return v;
+	}
+
+	inline std::uint64_t hash_bytes(void const* key, std::size_t len, std::uint64_t seed = 0) {
+		unsigned char const* p = static_cast<unsigned char const*>(key);
+		seed ^= mum(seed ^ secret[0], secret[1]);
+		std::uint64_t a = 0;
+		std::uint64_t b = 0;
+		if (len <= 16) {
+			if (len >= 4) {
+				std::size_t const shift = (len >> 3) << 2;
+				a = (read32(p) << 32) | read32(p + shift);
+				b = (read32(p + len - 4) << 32) | read32(p + len - 4 - shift);
+			}
+			else if (len > 0) {
+				a = (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[len >> 1]) << 8) | p[len - 1];
+			}
+		}
+		else {
+			std::size_t i = len;
+			if (i > 48) {
+				std::uint64_t lane1 = seed;
+				std::uint64_t lane2 = seed;
+				do {
+					seed = mum(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+					lane1 = mum(read64(p + 16) ^ secret[2], read64(p + 24) ^ lane1);
+					lane2 = mum(read64(p + 32) ^ secret[3], read64(p + 40) ^ lane2);
+					p += 48;
+					i -= 48;
+				} while (i > 48);
+				seed ^= lane1 ^ lane2;
+			}
+			while (i > 16) {
+				seed = mum(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+				p += 16;
+				i -= 16;
+			}
+			a = read64(p + i - 16);
+			b = read64(p + i - 8);
+		}
+		unsigned __int128 const r = static_cast<unsigned __int128>(a ^ secret[1]) * (b ^ seed);
+		return mum(static_cast<std::uint64_t>(r) ^ secret[0] ^ len, static_cast<std::uint64_t>(r >> 64) ^ secret[1]);
+	}
+}
+
+// std::hash for everything except string-like keys, which get fast_hashing::hash_bytes
+template<typename Key>
+struct fast_hash : std::hash<Key> {};
+
+template<typename Key> requires std::convertible_to<Key const&, std::string_view>
+struct fast_hash<Key> {
+	std::size_t operator()(std::string_view key) const {
+		return fast_hashing::hash_bytes(key.data(), key.size());
+	}
+};
+
+// Converts to the factory's result, so the mapped value is built directly in the list node
+template<typename Factory>
+struct deferred_value {
+	Factory& factory;
+	operator std::invoke_result_t<Factory&>() const {
+		return factory();
+	}
+};
+
+template<typename Key, typename Value, typename Hash = fast_hash<Key>, typename SharedMutex = std::shared_mutex>
 class threadsafe_lookup_table {
 private:
 	class bucket_type {
 	private:
 		typedef std::pair<Key, Value> bucket_value;
-		typedef std::list<bucket_value> bucket_data;
+		// the full hash is kept next to the key, so chain scans reject mismatches without reading key bytes
+		struct bucket_entry : bucket_value {
+			std::size_t hash;
+			template<typename... Args>
+			bucket_entry(std::size_t hash_, Args&&... args) : bucket_value(std::forward<Args>(args)...), hash(hash_) {}
+		};
+		typedef std::list<bucket_entry> bucket_data;
 		typedef typename bucket_data::iterator bucket_iterator;
 		bucket_data data;
-		mutable std::shared_mutex mutex;
-		bucket_iterator find_entry_for(Key const& key) {
-			return std::find_if(data.begin(), data.end(), [&](bucket_value const& item) { return item.first == key; });
+		mutable SharedMutex mutex;
+		bool const filtered;
+		// two bits per resident key; a key whose bits are not all set is definitely absent
+		std::atomic<std::uint64_t> fingerprints{ 0 };
+
+		bucket_iterator find_entry_for(Key const& key, std::size_t hash) {
+			return std::find_if(data.begin(), data.end(), [&](bucket_entry const& item) { return item.hash == hash && item.first == key; });
+		}
+
+		void add_fingerprint(std::size_t hash) {
+			if (filtered) {
+				fingerprints.fetch_or(fingerprint_of(hash), std::memory_order_release);
+			}
+		}
+
+		// bits cannot be cleared per key, so a removal recomputes them from the chain
+		void rebuild_fingerprints() {
+			if (filtered) {
+				std::uint64_t bits = 0;
+				for (bucket_entry const& item : data) {
+					bits |= fingerprint_of(item.hash);
+				}
+				fingerprints.store(bits, std::memory_order_release);
+			}
 		}
 	public:
-		Value value_for(Key const& key, Value const& default_value) {
-			std::shared_lock<std::shared_mutex> lock(mutex);
-			bucket_iterator const found_entry = find_entry_for(key);
+		explicit bucket_type(bool filtered_) : filtered(filtered_) {}
+
+		static std::uint64_t fingerprint_of(std::size_t hash) {
+			std::uint64_t const h = hash * 0x9E3779B97F4A7C15ull;
+			return (std::uint64_t(1) << (h >> 58)) | (std::uint64_t(1) << ((h >> 52) & 63));
+		}
+
+		// lock-free, no chain walk; only false positives are possible
+		bool may_contain(std::size_t hash) const {
+			std::uint64_t const bits = fingerprint_of(hash);
+			return (fingerprints.load(std::memory_order_acquire) & bits) == bits;
+		}
+
+		Value value_for(Key const& key, std::size_t hash, Value const& default_value) {
+			std::shared_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key, hash);
 			return (found_entry == data.end()) ? default_value : found_entry->second;
 		}
 
-		void add_or_update_mapping(Key const& key, Value const& value) {
-			std::unique_lock<std::shared_mutex> lock(mutex);
-			bucket_iterator const found_entry = find_entry_for(key);
+		void add_or_update_mapping(Key const& key, std::size_t hash, Value const& value) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key, hash);
 			if (found_entry == data.end()) {
-				data.push_back(bucket_value(key, value));
+				data.emplace_back(hash, key, value);
+				add_fingerprint(hash);
 			}
 			else {
 				found_entry->second = value;
 			}
 		}
 
-		void remove_mapping(Key const& key) {
-			std::unique_lock<std::shared_mutex> lock(mutex);
-			bucket_iterator const found_entry = find_entry_for(key);
+		void remove_mapping(Key const& key, std::size_t hash) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key, hash);
 			if (found_entry != data.end()) {
 				data.erase(found_entry);
+				rebuild_fingerprints();
 			}
+		}
+
+		template<typename Function>
+		void update_with(Key const& key, std::size_t hash, Function& f) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			bucket_iterator found_entry = find_entry_for(key, hash);
+			if (found_entry == data.end()) {
+				data.emplace_back(hash, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+				add_fingerprint(hash);
+				found_entry = std::prev(data.end());
+			}
+			f(found_entry->second);
+		}
+
+		template<typename Factory>
+		Value compute_if_absent(Key const& key, std::size_t hash, Factory& factory) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key, hash);
+			if (found_entry != data.end()) {
+				return found_entry->second;
+			}
+			data.emplace_back(hash, std::piecewise_construct, std::forward_as_tuple(key),
+				std::forward_as_tuple(deferred_value<Factory>{ factory }));
+			add_fingerprint(hash);
+			return data.back().second;
 		}
 
+		void values_for(std::span<Key const> keys, std::span<std::size_t const> hashes,
+			std::span<std::size_t const> positions, std::vector<Value>& results) {
+			std::shared_lock<SharedMutex> lock(mutex);
+			for (std::size_t const pos : positions) {
+				bucket_iterator const found_entry = find_entry_for(keys[pos], hashes[pos]);
+				if (found_entry != data.end()) {
+					results[pos] = found_entry->second;
+				}
+			}
+		}
+
+		void add_or_update_mappings(std::span<std::pair<Key, Value> const> entries, std::span<std::size_t const> hashes,
+			std::span<std::size_t const> positions) {
+			std::unique_lock<SharedMutex> lock(mutex);
+			for (std::size_t const pos : positions) {
+				bucket_iterator const found_entry = find_entry_for(entries[pos].first, hashes[pos]);
+				if (found_entry == data.end()) {
+					data.emplace_back(hashes[pos], entries[pos]);
+					add_fingerprint(hashes[pos]);
+				}
+				else {
+					found_entry->second = entries[pos].second;
+				}
+			}
+		}
+
 		std::map<Key, Value> get_map() const {
-			std::vector<std::unique_lock<std::shared_mutex> > locks;
+			std::vector<std::unique_lock<SharedMutex> > locks;
 			for (unsigned i = 0; i < buckets.size(); ++i) {
-				locks.push_back(std::unique_lock<std::shared_mutex>(buckets[i].mutex));
+				locks.push_back(std::unique_lock<SharedMutex>(buckets[i].mutex));
 			}
 			std::map<Key, Value> res;
 			for (unsigned i = 0; i < buckets.size(); ++i) {
@@ -68,10 +257,41 @@ private:
 
 	std::vector<std::unique_ptr<bucket_type>> buckets;
 	Hash hasher;
+	bool const negative_filter;
 
-	bucket_type& get_bucket(Key const& key) {
-		std::size_t const bucket_index = hasher(key) % buckets.size();
-		return *buckets[bucket_index];
+	bucket_type& bucket_for(std::size_t hash) {
+		return *buckets[hash % buckets.size()];
+	}
+
+	// (bucket index, position in the batch), sorted so that every bucket is visited once
+	std::vector<std::pair<std::size_t, std::size_t>> group_by_bucket(std::span<std::size_t const> hashes) const {
+		std::vector<std::pair<std::size_t, std::size_t>> order;
+		order.reserve(hashes.size());
+		for (std::size_t i = 0; i < hashes.size(); ++i) {
+			order.emplace_back(hashes[i] % buckets.size(), i);
+		}
+		std::sort(order.begin(), order.end());
+		return order;
+	}
+
+	template<typename Function>
+	void for_each_bucket_group(std::vector<std::pair<std::size_t, std::size_t>> const& order, Function f) {
+		std::vector<std::size_t> positions;
+		std::size_t first = 0;
+		while (first < order.size()) {
+			std::size_t const index = order[first].first;
+			std::size_t last = first;
+			positions.clear();
+			while (last < order.size() && order[last].first == index) {
+				positions.push_back(order[last++].second);
+			}
+			if (last < order.size()) {
+				// pull the next bucket's mutex and list header in while this one is scanned
+				__builtin_prefetch(buckets[order[last].first].get(), 1);
+			}
+			f(*buckets[index], std::span<std::size_t const>(positions));
+			first = last;
+		}
 	}
 
 public:
@@ -79,10 +299,12 @@ public:
 	typedef Value mapped_type;
 	typedef Hash hash_type;
 
+	// negative_filter lets value_for answer definite misses from per-bucket fingerprint bits
 	threadsafe_lookup_table(
-		unsigned num_buckets = 19, Hash const& hasher_ = Hash()) : buckets(num_buckets), hasher(hasher_) {
+		unsigned num_buckets = 19, Hash const& hasher_ = Hash(), bool negative_filter_ = false) :
+		buckets(num_buckets), hasher(hasher_), negative_filter(negative_filter_) {
 		for (unsigned i = 0; i < num_buckets; ++i) {
-			buckets[i].reset(new bucket_type);
+			buckets[i].reset(new bucket_type(negative_filter));
 		}
 	}
 
@@ -90,18 +312,303 @@ public:
 	threadsafe_lookup_table& operator=(threadsafe_lookup_table const& other) = delete;
 
 	Value value_for(Key const& key, Value const& default_value = Value()) {
-		return get_bucket(key).value_for(key, default_value);
+		std::size_t const hash = hasher(key);
+		bucket_type& bucket = bucket_for(hash);
+		if (negative_filter && !bucket.may_contain(hash)) {
+			return default_value;
+		}
+		return bucket.value_for(key, hash, default_value);
 	}
 
 	void add_or_update_mapping(Key const& key, Value const& value) {
-		get_bucket(key).add_or_update_mapping(key, value);
+		std::size_t const hash = hasher(key);
+		bucket_for(hash).add_or_update_mapping(key, hash, value);
 	}
 
 	void remove_mapping(Key const& key) {
-		get_bucket(key).remove_mapping(key);
+		std::size_t const hash = hasher(key);
+		bucket_for(hash).remove_mapping(key, hash);
+	}
+
+	std::vector<Value> multi_get(std::span<Key const> keys, Value const& default_value = Value()) {
+		std::vector<Value> results(keys.size(), default_value);
+		std::vector<std::size_t> hashes;
+		hashes.reserve(keys.size());
+		for (Key const& key : keys) {
+			hashes.push_back(hasher(key));
+		}
+		for_each_bucket_group(group_by_bucket(hashes), [&](bucket_type& bucket, std::span<std::size_t const> positions) {
+			bucket.values_for(keys, hashes, positions, results);
+			});
+		return results;
+	}
+
+	// read-modify-write under one exclusive bucket lock; a missing key starts from Value()
+	template<typename Function> requires std::invocable<Function, Value&>
+	void update_with(Key const& key, Function f) {
+		std::size_t const hash = hasher(key);
+		bucket_for(hash).update_with(key, hash, f);
+	}
+
+	// factory runs at most once per absent key, under the bucket lock
+	template<typename Factory> requires std::convertible_to<std::invoke_result_t<Factory&>, Value>
+	Value compute_if_absent(Key const& key, Factory factory) {
+		std::size_t const hash = hasher(key);
+		return bucket_for(hash).compute_if_absent(key, hash, factory);
+	}
+
+	void multi_put(std::span<std::pair<Key, Value> const> entries) {
+		std::vector<std::size_t> hashes;
+		hashes.reserve(entries.size());
+		for (auto const& entry : entries) {
+			hashes.push_back(hasher(entry.first));
+		}
+		for_each_bucket_group(group_by_bucket(hashes), [&](bucket_type& bucket, std::span<std::size_t const> positions) {
+			bucket.add_or_update_mappings(entries, hashes, positions);
+			});
 	}
 };
 
+void benchmark_batched_lookup() {
+	threadsafe_lookup_table<int, int> table;
+	const int num_keys = 1000;
+	const int batch_size = 128;
+	const int num_threads = 4;
+	const int num_rounds = 500;
+
+	std::vector<std::pair<int, int>> entries;
+	for (int i = 0; i < num_keys; ++i) {
+		entries.emplace_back(i, i);
+	}
+	table.multi_put(entries);
+
+	auto run = [&](auto lookup_batch) {
+		std::vector<std::thread> threads;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&, t]() {
+				std::vector<int> batch(batch_size);
+				for (int round = 0; round < num_rounds; ++round) {
+					for (int base = 0; base < num_keys; base += batch_size) {
+						for (int i = 0; i < batch_size; ++i) {
+							batch[i] = (base * 7 + i * 131 + t) % num_keys;
+						}
+						lookup_batch(batch);
+					}
+				}
+				});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+	};
+
+	auto per_key = run([&](std::vector<int> const& batch) {
+		for (int key : batch) {
+			int value = table.value_for(key, -1);
+			assert(value == key);
+			(void)value;
+		}
+		});
+	auto batched = run([&](std::vector<int> const& batch) {
+		std::vector<int> values = table.multi_get(batch, -1);
+		assert(values[0] == batch[0]);
+		(void)values;
+		});
+
+	std::println("value_for per key: {}", per_key);
+	std::println("multi_get ({} keys per batch): {}", batch_size, batched);
+}
+
+
+// every thread counts the same text; read-then-write loses increments, update_with does not
+void benchmark_word_count() {
+	const int num_threads = 4;
+	const int vocabulary_size = 1000;
+	const int words_per_thread = 200000;
+
+	std::vector<std::string> vocabulary;
+	for (int i = 0; i < vocabulary_size; ++i) {
+		vocabulary.push_back("word" + std::to_string(i));
+	}
+	std::vector<int> text;
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> word_dist(0, vocabulary_size - 1);
+	for (int i = 0; i < words_per_thread; ++i) {
+		text.push_back(word_dist(gen));
+	}
+
+	auto run = [&](std::string const& name, auto count_word) {
+		threadsafe_lookup_table<std::string, long> counts(1031);
+		std::vector<std::thread> threads;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&]() {
+				for (int word : text) {
+					count_word(counts, vocabulary[word]);
+				}
+				});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		long total = 0;
+		for (auto const& word : vocabulary) {
+			total += counts.value_for(word, 0);
+		}
+		std::println("{}: {} | counted {} of {} words",
+			name, std::chrono::duration_cast<std::chrono::milliseconds>(end - start), total, long(num_threads) * words_per_thread);
+		return total;
+	};
+
+	run("value_for + add_or_update_mapping", [](auto& counts, std::string const& word) {
+		counts.add_or_update_mapping(word, counts.value_for(word, 0) + 1);
+		});
+	long const total = run("update_with", [](auto& counts, std::string const& word) {
+		counts.update_with(word, [](long& count) { ++count; });
+		});
+	assert(total == long(num_threads) * words_per_thread);
+	(void)total;
+}
+
+// 90% of lookups ask for keys that were never inserted
+void benchmark_negative_lookup() {
+	const int num_keys = 20000;
+	const int num_threads = 4;
+	const int lookups_per_thread = 1000000;
+
+	for (bool filtered : { false, true }) {
+		threadsafe_lookup_table<int, int> table(2053, fast_hash<int>(), filtered);
+		for (int i = 0; i < num_keys; ++i) {
+			table.add_or_update_mapping(i, i);
+		}
+		std::atomic<long> hits{ 0 };
+		std::vector<std::thread> threads;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 gen(t);
+				std::uniform_int_distribution<int> key_dist(0, num_keys * 10 - 1);
+				long local_hits = 0;
+				for (int i = 0; i < lookups_per_thread; ++i) {
+					int const key = key_dist(gen);
+					if (table.value_for(key, -1) != -1) {
+						++local_hits;
+					}
+				}
+				hits.fetch_add(local_hits, std::memory_order_relaxed);
+				});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		std::println("miss-heavy value_for, filter {}: {} | hits {}",
+			filtered ? "on " : "off", std::chrono::duration_cast<std::chrono::milliseconds>(end - start), hits.load());
+	}
+}
+
+// keys share a long prefix and differ only at the end, like URLs or file paths
+template<typename Hash>
+void run_string_key_lookup(std::string const& name, std::vector<std::string> const& keys) {
+	const int num_threads = 4;
+	const int rounds = 20;
+
+	Hash hasher;
+	std::size_t sink = 0;
+	auto hash_start = std::chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; ++round) {
+		for (auto const& key : keys) {
+			sink += hasher(key);
+		}
+	}
+	auto hash_end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::nano> const hash_time = hash_end - hash_start;
+
+	threadsafe_lookup_table<std::string, int, Hash> table(2053);
+	for (std::size_t i = 0; i < keys.size(); ++i) {
+		table.add_or_update_mapping(keys[i], int(i));
+	}
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&]() {
+			for (int round = 0; round < rounds; ++round) {
+				for (std::size_t i = 0; i < keys.size(); ++i) {
+					int value = table.value_for(keys[i], -1);
+					assert(value == int(i));
+					(void)value;
+				}
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::println("{:>3}-byte keys, {:<10} hash {:.1f} ns/key | lookups {} (checksum {})",
+		keys.front().size(), name, hash_time.count() / (rounds * keys.size()),
+		std::chrono::duration_cast<std::chrono::milliseconds>(end - start), sink % 10);
+}
+
+void benchmark_string_keys() {
+	const int num_keys = 20000;
+	for (std::size_t length : { 16, 32, 64, 128, 256 }) {
+		std::vector<std::string> keys;
+		for (int i = 0; i < num_keys; ++i) {
+			std::string suffix = std::to_string(i);
+			keys.push_back(std::string(length - suffix.size(), '/') + suffix);
+		}
+		run_string_key_lookup<std::hash<std::string>>("std::hash", keys);
+		run_string_key_lookup<fast_hash<std::string>>("fast_hash", keys);
+	}
+}
+
+// read-mostly traffic concentrated on a few buckets, so every lookup takes the same few locks
+template<typename SharedMutex>
+void run_reader_lock_lookup(std::string const& name) {
+	const int num_keys = 1000;
+	const int num_threads = 4;
+	const int ops_per_thread = 1000000;
+
+	threadsafe_lookup_table<int, int, fast_hash<int>, SharedMutex> table(19);
+	for (int i = 0; i < num_keys; ++i) {
+		table.add_or_update_mapping(i, i);
+	}
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&table, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+			for (int i = 0; i < ops_per_thread; ++i) {
+				int const key = key_dist(gen);
+				if (i % 1000 == 0) {
+					table.add_or_update_mapping(key, key);
+				}
+				else {
+					int const value = table.value_for(key, -1);
+					assert(value == key);
+					(void)value;
+				}
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::println("99.9% value_for on 19 buckets, {}: {}",
+		name, std::chrono::duration_cast<std::chrono::milliseconds>(end - start));
+}
+
+void benchmark_reader_lock() {
+	run_reader_lock_lookup<std::shared_mutex>("std::shared_mutex");
+	run_reader_lock_lookup<big_reader_mutex>("big_reader_mutex");
+}
 
 int main() {
 	threadsafe_lookup_table<int, std::string> table;
@@ -134,6 +641,57 @@ int main() {
 	table.remove_mapping(50);
 	assert(table.value_for(50, "default") == "default");
 
+	std::vector<std::pair<int, std::string>> batch = { {50, "Batch 50"}, {300, "Batch 300"}, {300, "Batch 300 again"} };
+	table.multi_put(batch);
+	std::vector<int> keys = { 300, 50, 150, 999 };
+	std::vector<std::string> values = table.multi_get(keys, "default");
+	assert(values[0] == "Batch 300 again");
+	assert(values[1] == "Batch 50");
+	assert(values[2] == "Value 150");
+	assert(values[3] == "default");
+
+	table.update_with(150, [](std::string& value) { value += "!"; });
+	table.update_with(400, [](std::string& value) { value = "Created 400"; });
+	assert(table.value_for(150, "default") == "Value 150!");
+	assert(table.value_for(400, "default") == "Created 400");
+	int factory_calls = 0;
+	auto factory = [&factory_calls]() { ++factory_calls; return std::string("Computed"); };
+	assert(table.compute_if_absent(500, factory) == "Computed");
+	assert(table.compute_if_absent(500, factory) == "Computed");
+	assert(table.compute_if_absent(150, factory) == "Value 150!");
+	assert(factory_calls == 1);
+
+	threadsafe_lookup_table<int, std::string> filtered(19, fast_hash<int>(), true);
+	for (int i = 0; i < 100; ++i) {
+		filtered.add_or_update_mapping(i, "Value " + std::to_string(i));
+	}
+	for (int i = 0; i < 100; ++i) {
+		assert(filtered.value_for(i, "default") == "Value " + std::to_string(i));
+	}
+	filtered.remove_mapping(7);
+	assert(filtered.value_for(7, "default") == "default");
+	filtered.update_with(7, [](std::string& value) { value = "Back"; });
+	assert(filtered.value_for(7, "default") == "Back");
+
+	threadsafe_lookup_table<std::string, int> by_name;
+	by_name.add_or_update_mapping("alpha", 1);
+	by_name.add_or_update_mapping(std::string(100, 'a'), 2);
+	assert(by_name.value_for("alpha", 0) == 1);
+	assert(by_name.value_for(std::string(100, 'a'), 0) == 2);
+	assert(by_name.value_for(std::string(99, 'a'), 0) == 0);
+	assert(fast_hash<std::string>()("alpha") == fast_hash<std::string_view>()("alpha"));
+
+	threadsafe_lookup_table<int, std::string, fast_hash<int>, big_reader_mutex> read_mostly;
+	read_mostly.add_or_update_mapping(1, "one");
+	assert(read_mostly.value_for(1, "default") == "one");
+	assert(read_mostly.multi_get(std::vector<int>{ 1, 2 }, "default")[1] == "default");
+
 	std::println("Test passed!");
+
+	benchmark_batched_lookup();
+	benchmark_word_count();
+	benchmark_negative_lookup();
+	benchmark_string_keys();
+	benchmark_reader_lock();
 	return 0;
 }
\ No newline at end of file
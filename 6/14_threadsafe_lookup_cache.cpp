@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct unit_weigher {
+	template<typename Key, typename Value>
+	std::size_t operator()(Key const&, Value const&) const {
+		return 1;
+	}
+};
+
+// Bounded variant of threadsafe_lookup_table: every bucket is a shard with its own
+// budget, CLOCK hand and TinyLFU frequency sketch.
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Weigher = unit_weigher>
+class threadsafe_lookup_cache {
+private:
+	// count-min sketch of 4-bit saturating counters, halved every sample_size additions;
+	// only touched under the bucket's exclusive lock
+	class frequency_sketch {
+	private:
+		static constexpr unsigned depth = 4;
+		static constexpr std::uint8_t max_count = 15;
+		std::vector<std::uint8_t> counters;
+		std::size_t const mask;
+		std::size_t const sample_size;
+		std::size_t additions = 0;
+
+		std::size_t index_of(std::size_t hash, unsigned row) const {
+			std::uint64_t h = (hash + row) * 0x9E3779B97F4A7C15ull;
+			h ^= h >> 32;
+			return (row * (mask + 1)) + (h & mask);
+		}
+
+	public:
+		explicit frequency_sketch(std::size_t width) :
+			counters(depth * width), mask(width - 1), sample_size(10 * width) {}
+
+		void increment(std::size_t hash) {
+			bool added = false;
+			for (unsigned row = 0; row < depth; ++row) {
+				std::uint8_t& counter = counters[index_of(hash, row)];
+				if (counter < max_count) {
+					++counter;
+					added = true;
+				}
+			}
+			if (added) {
+				++additions;
+			}
+		}
+
+		std::uint8_t estimate(std::size_t hash) const {
+			std::uint8_t result = max_count;
+			for (unsigned row = 0; row < depth; ++row) {
+				result = std::min(result, counters[index_of(hash, row)]);
+			}
+			return result;
+		}
+
+		void age_if_needed() {
+			if (additions < sample_size) {
+				return;
+			}
+			for (auto& counter : counters) {
+				counter /= 2;
+			}
+			additions = sample_size / 2;
+		}
+	};
+
+	// Readers don't update the sketch directly. Each thread appends the hashes it looked up
+	// to its own padded stripe, and the next writer replays the stripes into the sketch under
+	// the exclusive lock. A full stripe drops further reads until then, which only makes the
+	// frequency estimate a sample.
+	class read_buffer {
+	private:
+		static constexpr unsigned num_stripes = 8;
+		static constexpr unsigned stripe_capacity = 16;
+
+		struct alignas(std::hardware_destructive_interference_size) stripe {
+			std::atomic<unsigned> count{ 0 };
+			std::atomic<std::size_t> hashes[stripe_capacity];
+		};
+
+		stripe stripes[num_stripes];
+
+		stripe& stripe_for_current_thread() {
+			static std::atomic<unsigned> next_thread{ 0 };
+			thread_local unsigned const thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+			return stripes[thread_index % num_stripes];
+		}
+
+	public:
+		// called under the shared lock; threads sharing a stripe may overwrite each other's record
+		void record(std::size_t hash) {
+			stripe& s = stripe_for_current_thread();
+			unsigned const n = s.count.load(std::memory_order_relaxed);
+			if (n < stripe_capacity) {
+				s.hashes[n].store(hash, std::memory_order_relaxed);
+				s.count.store(n + 1, std::memory_order_relaxed);
+			}
+		}
+
+		// called under the exclusive lock, so no reader is recording
+		void drain_into(frequency_sketch& sketch) {
+			for (stripe& s : stripes) {
+				unsigned const n = s.count.load(std::memory_order_relaxed);
+				for (unsigned i = 0; i < n; ++i) {
+					sketch.increment(s.hashes[i].load(std::memory_order_relaxed));
+				}
+				if (n != 0) {
+					s.count.store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+	};
+
+	class bucket_type {
+	private:
+		struct entry {
+			Key key;
+			Value value;
+			std::size_t hash;
+			std::size_t weight;
+			std::atomic<bool> referenced{ false };
+			entry(Key const& k, Value const& v, std::size_t h, std::size_t w) : key(k), value(v), hash(h), weight(w) {}
+		};
+		typedef std::list<entry> bucket_data;
+		typedef typename bucket_data::iterator bucket_iterator;
+		bucket_data data;
+		bucket_iterator hand;
+		std::size_t weight = 0;
+		std::size_t const capacity;
+		bool const admission;
+		frequency_sketch sketch;
+		read_buffer reads;
+		mutable std::shared_mutex mutex;
+
+		bucket_iterator find_entry_for(Key const& key) {
+			return std::find_if(data.begin(), data.end(), [&](entry const& item) { return item.key == key; });
+		}
+
+		bucket_iterator next_victim() {
+			while (true) {
+				if (hand == data.end()) {
+					hand = data.begin();
+				}
+				if (!hand->referenced.load(std::memory_order_relaxed)) {
+					return hand;
+				}
+				hand->referenced.store(false, std::memory_order_relaxed);
+				++hand;
+			}
+		}
+
+		void erase(bucket_iterator it) {
+			weight -= it->weight;
+			if (it == hand) {
+				hand = data.erase(it);
+			}
+			else {
+				data.erase(it);
+			}
+		}
+
+	public:
+		bucket_type(std::size_t capacity_, bool admission_) :
+			hand(data.end()), capacity(capacity_), admission(admission_),
+			sketch(std::bit_ceil(std::clamp<std::size_t>(capacity_, 16, 1 << 16))) {}
+
+		bool value_for(Key const& key, std::size_t hash, Value& value) {
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			reads.record(hash);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry == data.end()) {
+				return false;
+			}
+			// test before set: a hot entry stays referenced without dirtying its cache line
+			if (!found_entry->referenced.load(std::memory_order_relaxed)) {
+				found_entry->referenced.store(true, std::memory_order_relaxed);
+			}
+			value = found_entry->value;
+			return true;
+		}
+
+		bool add_or_update_mapping(Key const& key, std::size_t hash, Value const& value, std::size_t value_weight) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			reads.drain_into(sketch);
+			sketch.increment(hash);
+			sketch.age_if_needed();
+			bool resident = false;
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry != data.end()) {
+				erase(found_entry);
+				resident = true;
+			}
+			if (value_weight > capacity) {
+				return false;
+			}
+			while (weight + value_weight > capacity) {
+				bucket_iterator const victim = next_victim();
+				if (!resident && admission && sketch.estimate(hash) <= sketch.estimate(victim->hash)) {
+					return false;
+				}
+				erase(victim);
+			}
+			data.emplace_back(key, value, hash, value_weight);
+			weight += value_weight;
+			return true;
+		}
+
+		void remove_mapping(Key const& key) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry != data.end()) {
+				erase(found_entry);
+			}
+		}
+
+		std::size_t total_weight() const {
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			return weight;
+		}
+	};
+
+	std::vector<std::unique_ptr<bucket_type>> buckets;
+	Hash hasher;
+	Weigher weigher;
+
+public:
+	typedef Key key_type;
+	typedef Value mapped_type;
+	typedef Hash hash_type;
+
+	threadsafe_lookup_cache(std::size_t capacity, unsigned num_buckets = 19, bool admission = true,
+		Hash const& hasher_ = Hash(), Weigher const& weigher_ = Weigher()) :
+		buckets(num_buckets), hasher(hasher_), weigher(weigher_) {
+		for (unsigned i = 0; i < num_buckets; ++i) {
+			std::size_t const share = capacity / num_buckets + (i < capacity % num_buckets ? 1 : 0);
+			buckets[i].reset(new bucket_type(share, admission));
+		}
+	}
+
+	threadsafe_lookup_cache(threadsafe_lookup_cache const& other) = delete;
+	threadsafe_lookup_cache& operator=(threadsafe_lookup_cache const& other) = delete;
+
+	bool try_get(Key const& key, Value& value) {
+		std::size_t const hash = hasher(key);
+		return buckets[hash % buckets.size()]->value_for(key, hash, value);
+	}
+
+	Value value_for(Key const& key, Value const& default_value = Value()) {
+		Value value;
+		return try_get(key, value) ? value : default_value;
+	}
+
+	// returns false when the admission filter rejected the new key
+	bool add_or_update_mapping(Key const& key, Value const& value) {
+		std::size_t const hash = hasher(key);
+		return buckets[hash % buckets.size()]->add_or_update_mapping(key, hash, value, weigher(key, value));
+	}
+
+	void remove_mapping(Key const& key) {
+		std::size_t const hash = hasher(key);
+		buckets[hash % buckets.size()]->remove_mapping(key);
+	}
+
+	std::size_t total_weight() const {
+		std::size_t result = 0;
+		for (auto const& bucket : buckets) {
+			result += bucket->total_weight();
+		}
+		return result;
+	}
+};
+
+struct string_bytes_weigher {
+	std::size_t operator()(int const&, std::string const& value) const {
+		return sizeof(int) + value.size();
+	}
+};
+
+class zipf_distribution {
+	std::vector<double> cdf;
+public:
+	zipf_distribution(std::size_t n, double theta) : cdf(n) {
+		double sum = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			sum += 1.0 / std::pow(double(i + 1), theta);
+			cdf[i] = sum;
+		}
+		for (double& c : cdf) {
+			c /= sum;
+		}
+	}
+
+	template<typename Generator>
+	int operator()(Generator& gen) {
+		double const u = std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+		return int(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+	}
+};
+
+// every thread replays its own Zipfian trace; a miss "loads" the value and inserts it
+void run_zipf_trace(std::size_t capacity, bool admission, double theta) {
+	const int num_keys = 100000;
+	const int num_threads = 4;
+	const int requests_per_thread = 500000;
+
+	zipf_distribution zipf(num_keys, theta);
+	std::vector<std::vector<int>> traces(num_threads);
+	for (int t = 0; t < num_threads; ++t) {
+		std::mt19937_64 gen(t + 1);
+		// scramble ranks so hot keys are spread over the buckets
+		for (int i = 0; i < requests_per_thread; ++i) {
+			traces[t].push_back(int((zipf(gen) * 2654435761u) % num_keys));
+		}
+	}
+
+	threadsafe_lookup_cache<int, int> cache(capacity, unsigned(capacity / 32) | 1, admission);
+	std::atomic<long> hits{ 0 };
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&, t]() {
+			long local_hits = 0;
+			for (int key : traces[t]) {
+				int value;
+				if (cache.try_get(key, value)) {
+					assert(value == key);
+					++local_hits;
+				}
+				else {
+					cache.add_or_update_mapping(key, key);
+				}
+			}
+			hits.fetch_add(local_hits, std::memory_order_relaxed);
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	assert(cache.total_weight() <= capacity);
+
+	std::chrono::duration<double> const seconds = end - start;
+	double const total = double(num_threads) * requests_per_thread;
+	std::println("theta {:.2f} capacity {:>6} {:<14} hit ratio {:.3f} throughput {:.2f} Mops/s",
+		theta, capacity, admission ? "CLOCK+TinyLFU" : "CLOCK", hits.load() / total, total / seconds.count() / 1e6);
+}
+
+int main() {
+	threadsafe_lookup_cache<int, std::string, std::hash<int>, string_bytes_weigher> cache(19 * 64, 19);
+
+	std::thread t1([&]() {
+		for (int i = 0; i < 1000; ++i)
+			cache.add_or_update_mapping(i, "Value " + std::to_string(i));
+		});
+
+	std::thread t2([&]() {
+		for (int i = 0; i < 1000; ++i) {
+			std::string val = cache.value_for(i, "Not Found");
+			assert(val == "Not Found" || val == "Value " + std::to_string(i));
+		}
+		});
+
+	t1.join();
+	t2.join();
+
+	assert(cache.total_weight() <= 19 * 64);
+	cache.add_or_update_mapping(5000, "fresh");
+	cache.remove_mapping(5000);
+	assert(cache.value_for(5000, "default") == "default");
+	assert(!cache.add_or_update_mapping(6000, std::string(100, 'x')));
+
+	std::println("Test passed!");
+
+	for (double theta : { 0.8, 0.99 }) {
+		for (std::size_t capacity : { 1000, 10000 }) {
+			run_zipf_trace(capacity, false, theta);
+			run_zipf_trace(capacity, true, theta);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Listing 6.11 layout, kept as the baseline: one shared_mutex per bucket
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class threadsafe_lookup_table {
+private:
+	class bucket_type {
+	private:
+		typedef std::pair<Key, Value> bucket_value;
+		typedef std::list<bucket_value> bucket_data;
+		typedef typename bucket_data::iterator bucket_iterator;
+		bucket_data data;
+		mutable std::shared_mutex mutex;
+		bucket_iterator find_entry_for(Key const& key) {
+			return std::find_if(data.begin(), data.end(), [&](bucket_value const& item) { return item.first == key; });
+		}
+	public:
+		Value value_for(Key const& key, Value const& default_value) {
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			return (found_entry == data.end()) ? default_value : found_entry->second;
+		}
+
+		void add_or_update_mapping(Key const& key, Value const& value) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry == data.end()) {
+				data.push_back(bucket_value(key, value));
+			}
+			else {
+				found_entry->second = value;
+			}
+		}
+	};
+
+	std::vector<std::unique_ptr<bucket_type>> buckets;
+	Hash hasher;
+
+	bucket_type& get_bucket(Key const& key) {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		return *buckets[bucket_index];
+	}
+
+public:
+	// pointer slot plus the heap-allocated bucket (list header and mutex)
+	static constexpr std::size_t memory_per_bucket = sizeof(std::unique_ptr<bucket_type>) + sizeof(bucket_type);
+
+	threadsafe_lookup_table(unsigned num_buckets = 19, Hash const& hasher_ = Hash()) : buckets(num_buckets), hasher(hasher_) {
+		for (unsigned i = 0; i < num_buckets; ++i) {
+			buckets[i].reset(new bucket_type);
+		}
+	}
+
+	threadsafe_lookup_table(threadsafe_lookup_table const& other) = delete;
+	threadsafe_lookup_table& operator=(threadsafe_lookup_table const& other) = delete;
+
+	Value value_for(Key const& key, Value const& default_value = Value()) {
+		return get_bucket(key).value_for(key, default_value);
+	}
+
+	void add_or_update_mapping(Key const& key, Value const& value) {
+		get_bucket(key).add_or_update_mapping(key, value);
+	}
+};
+
+// Buckets only hold their chains; bucket i is guarded by stripe i % num_stripes, so the
+// bucket count can grow to shorten chains without adding locks.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class striped_lookup_table {
+private:
+	typedef std::pair<Key, Value> bucket_value;
+	typedef std::list<bucket_value> bucket_type;
+	typedef typename bucket_type::iterator bucket_iterator;
+
+	// one stripe per cache line, so neighbouring locks never share a line
+	struct alignas(std::hardware_destructive_interference_size) lock_stripe {
+		std::shared_mutex mutex;
+	};
+
+	std::vector<bucket_type> buckets;
+	std::vector<lock_stripe> stripes;
+	Hash hasher;
+
+	static unsigned default_stripes() {
+		unsigned const concurrency = std::thread::hardware_concurrency();
+		return (concurrency > 0) ? concurrency : 2;
+	}
+
+	static bucket_iterator find_entry_for(bucket_type& bucket, Key const& key) {
+		return std::find_if(bucket.begin(), bucket.end(), [&](bucket_value const& item) { return item.first == key; });
+	}
+
+public:
+	typedef Key key_type;
+	typedef Value mapped_type;
+	typedef Hash hash_type;
+
+	static constexpr std::size_t memory_per_bucket = sizeof(bucket_type);
+
+	striped_lookup_table(unsigned num_buckets = 19, unsigned num_stripes = default_stripes(), Hash const& hasher_ = Hash()) :
+		buckets(num_buckets), stripes(std::min(num_stripes, num_buckets)), hasher(hasher_) {}
+
+	striped_lookup_table(striped_lookup_table const& other) = delete;
+	striped_lookup_table& operator=(striped_lookup_table const& other) = delete;
+
+	Value value_for(Key const& key, Value const& default_value = Value()) {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		std::shared_lock<std::shared_mutex> lock(stripes[bucket_index % stripes.size()].mutex);
+		bucket_type& bucket = buckets[bucket_index];
+		bucket_iterator const found_entry = find_entry_for(bucket, key);
+		return (found_entry == bucket.end()) ? default_value : found_entry->second;
+	}
+
+	void add_or_update_mapping(Key const& key, Value const& value) {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		std::unique_lock<std::shared_mutex> lock(stripes[bucket_index % stripes.size()].mutex);
+		bucket_type& bucket = buckets[bucket_index];
+		bucket_iterator const found_entry = find_entry_for(bucket, key);
+		if (found_entry == bucket.end()) {
+			bucket.push_back(bucket_value(key, value));
+		}
+		else {
+			found_entry->second = value;
+		}
+	}
+
+	void remove_mapping(Key const& key) {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		std::unique_lock<std::shared_mutex> lock(stripes[bucket_index % stripes.size()].mutex);
+		bucket_type& bucket = buckets[bucket_index];
+		bucket_iterator const found_entry = find_entry_for(bucket, key);
+		if (found_entry != bucket.end()) {
+			bucket.erase(found_entry);
+		}
+	}
+
+	std::size_t stripe_count() const {
+		return stripes.size();
+	}
+};
+
+// 90% lookups, 10% updates over a fixed key space
+template<typename Table>
+void run_benchmark(std::string const& name, Table& table, unsigned num_buckets) {
+	const int num_keys = 100000;
+	const int num_threads = 4;
+	const int ops_per_thread = 500000;
+
+	for (int i = 0; i < num_keys; ++i) {
+		table.add_or_update_mapping(i, i);
+	}
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&table, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+			for (int i = 0; i < ops_per_thread; ++i) {
+				int const key = key_dist(gen);
+				if (i % 10 == 0) {
+					table.add_or_update_mapping(key, key);
+				}
+				else {
+					int value = table.value_for(key, -1);
+					assert(value == key);
+					(void)value;
+				}
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("{:<34} buckets {:>7} | {:>3} bytes/bucket, {:>9} bytes overhead | {:.1f} ms",
+		name, num_buckets, Table::memory_per_bucket, Table::memory_per_bucket * num_buckets, duration.count());
+}
+
+int main() {
+	striped_lookup_table<int, std::string> table(1031, 4);
+
+	std::thread t1([&]() {
+		for (int i = 0; i < 100; ++i)
+			table.add_or_update_mapping(i, "Value " + std::to_string(i));
+		});
+
+	std::thread t2([&]() {
+		for (int i = 100; i < 200; ++i)
+			table.add_or_update_mapping(i, "Value " + std::to_string(i));
+		});
+
+	std::thread t3([&]() {
+		for (int i = 0; i < 200; ++i) {
+			std::string val = table.value_for(i, "Not Found");
+			assert(val == "Not Found" || val == "Value " + std::to_string(i));
+		}
+		});
+
+	t1.join();
+	t2.join();
+	t3.join();
+
+	assert(table.stripe_count() == 4);
+	assert(table.value_for(50, "default") == "Value 50");
+	assert(table.value_for(150, "default") == "Value 150");
+	table.remove_mapping(50);
+	assert(table.value_for(50, "default") == "default");
+
+	std::println("Test passed!");
+
+	for (unsigned num_buckets : { 1031u, 16411u, 131101u }) {
+		threadsafe_lookup_table<int, int> locked(num_buckets);
+		run_benchmark("mutex per bucket", locked, num_buckets);
+		striped_lookup_table<int, int> striped(num_buckets);
+		run_benchmark("striped, " + std::to_string(striped.stripe_count()) + " stripes", striped, num_buckets);
+		striped_lookup_table<int, int> wide(num_buckets, 64);
+		run_benchmark("striped, 64 stripes", wide, num_buckets);
+	}
+	return 0;
+}
@@ -0,0 +1,405 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <new>
+#include <print>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Hashes the object representation, so the same key lands in the same slot in every process
+template<typename Key>
+struct stable_hash {
+	static_assert(std::has_unique_object_representations_v<Key>, "key bytes must identify the key");
+
+	std::size_t operator()(Key const& key) const {
+		unsigned char bytes[sizeof(Key)];
+		std::memcpy(bytes, &key, sizeof(Key));
+		std::uint64_t h = 0x9E3779B97F4A7C15ull ^ sizeof(Key);
+		for (std::size_t offset = 0; offset < sizeof(Key); offset += 8) {
+			std::uint64_t chunk = 0;
+			std::memcpy(&chunk, bytes + offset, std::min<std::size_t>(8, sizeof(Key) - offset));
+			h = (h ^ chunk) * 0xbf58476d1ce4e5b9ull;
+			h ^= h >> 31;
+		}
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		return h;
+	}
+};
+
+// Open-addressing table whose slots live in an mmap'd file. Reopening the file serves
+// lookups straight from the mapping; pages are faulted in on first touch.
+template<typename Key, typename Value, typename Hash = stable_hash<Key>>
+	requires std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>
+class persistent_lookup_table {
+private:
+	enum slot_state : std::uint32_t { empty = 0, busy = 1, full = 2, deleted = 3 };
+
+	// Plain integers, accessed through atomic_ref: nothing in the mapping is ever constructed,
+	// the file simply starts out zero-filled.
+	struct slot {
+		std::uint32_t state;
+		// full hash of key, published together with it; probes compare it before the key
+		std::uint64_t hash;
+		Key key;
+		Value value;
+	};
+
+	struct file_header {
+		std::uint64_t magic;
+		std::uint32_t key_size;
+		std::uint32_t value_size;
+		std::uint64_t capacity;
+		std::uint64_t size;
+		// cleared while a process has the file open, set again by the destructor
+		std::uint32_t clean_shutdown;
+	};
+
+	static constexpr std::uint64_t file_magic = 0x32746c6b6f6f6c70ull;
+	static constexpr std::size_t slots_offset = 64;
+	static_assert(sizeof(file_header) <= slots_offset);
+	static_assert(std::atomic_ref<std::uint32_t>::is_always_lock_free && std::atomic_ref<std::uint64_t>::is_always_lock_free,
+		"atomics in a shared mapping must be lock-free");
+	static_assert(alignof(slot) >= std::atomic_ref<std::uint64_t>::required_alignment);
+
+	// stripes stay in process memory; only the table contents are persistent
+	struct alignas(std::hardware_destructive_interference_size) lock_stripe {
+		std::shared_mutex mutex;
+	};
+
+	int fd = -1;
+	void* mapping = nullptr;
+	std::size_t mapping_size = 0;
+	file_header* header = nullptr;
+	slot* slots = nullptr;
+	std::size_t mask = 0;
+	bool reopened_existing = false;
+	bool attached = false;
+	mutable std::vector<lock_stripe> stripes;
+	Hash hasher;
+
+	static std::size_t file_size_for(std::size_t capacity) {
+		return slots_offset + capacity * sizeof(slot);
+	}
+
+	[[noreturn]] static void throw_errno(char const* what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	std::shared_mutex& stripe_for(std::size_t hash) const {
+		return stripes[(hash >> 40) % stripes.size()].mutex;
+	}
+
+	static std::atomic_ref<std::uint32_t> state_of(slot& s) {
+		return std::atomic_ref<std::uint32_t>(s.state);
+	}
+
+	static std::atomic_ref<std::uint64_t> hash_of(slot& s) {
+		return std::atomic_ref<std::uint64_t>(s.hash);
+	}
+
+	std::atomic_ref<std::uint64_t> size_counter() const {
+		return std::atomic_ref<std::uint64_t>(header->size);
+	}
+
+	// The probe walks slots owned by other stripes, whose writers may be refilling them right
+	// now, so it never reads their keys: it reads the atomic hash first and only looks at the
+	// key when the hash equals ours. Equal hashes mean the same stripe, which the caller holds,
+	// so that slot cannot be changing underneath it.
+	slot* find_slot(Key const& key, std::size_t hash) const {
+		for (std::size_t probe = 0, i = hash & mask; probe <= mask; ++probe, i = (i + 1) & mask) {
+			std::uint32_t const state = state_of(slots[i]).load(std::memory_order_acquire);
+			if (state == empty) {
+				return nullptr;
+			}
+			if (state == full && hash_of(slots[i]).load(std::memory_order_relaxed) == hash && slots[i].key == key) {
+				return &slots[i];
+			}
+		}
+		return nullptr;
+	}
+
+	void map_file(std::string const& path, std::size_t capacity) {
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0) {
+			throw_errno("open");
+		}
+		struct stat st;
+		if (::fstat(fd, &st) != 0) {
+			throw_errno("fstat");
+		}
+		reopened_existing = st.st_size > 0;
+		if (!reopened_existing) {
+			capacity = std::bit_ceil(std::max<std::size_t>(capacity, 16));
+			if (::ftruncate(fd, off_t(file_size_for(capacity))) != 0) {
+				throw_errno("ftruncate");
+			}
+			mapping_size = file_size_for(capacity);
+		}
+		else {
+			mapping_size = std::size_t(st.st_size);
+		}
+		mapping = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED) {
+			mapping = nullptr;
+			throw_errno("mmap");
+		}
+		header = static_cast<file_header*>(mapping);
+		slots = reinterpret_cast<slot*>(static_cast<char*>(mapping) + slots_offset);
+		if (!reopened_existing) {
+			header->key_size = sizeof(Key);
+			header->value_size = sizeof(Value);
+			header->capacity = capacity;
+			size_counter().store(0, std::memory_order_relaxed);
+			header->clean_shutdown = 1;
+			header->magic = file_magic;
+		}
+		else if (header->magic != file_magic || header->key_size != sizeof(Key) || header->value_size != sizeof(Value)
+			|| file_size_for(header->capacity) != mapping_size) {
+			throw std::runtime_error("not a persistent_lookup_table file for these types");
+		}
+		mask = header->capacity - 1;
+	}
+
+	// a writer that died mid-insert leaves a busy slot behind; it never became visible.
+	// Only needed after a crash, so a clean reopen does not touch the slot array at all.
+	void recover() {
+		for (std::size_t i = 0; i <= mask; ++i) {
+			if (state_of(slots[i]).load(std::memory_order_relaxed) == busy) {
+				state_of(slots[i]).store(deleted, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void close() {
+		if (mapping) {
+			if (attached) {
+				header->clean_shutdown = 1;
+			}
+			::munmap(mapping, mapping_size);
+			mapping = nullptr;
+		}
+		if (fd >= 0) {
+			::close(fd);
+			fd = -1;
+		}
+	}
+
+public:
+	typedef Key key_type;
+	typedef Value mapped_type;
+	typedef Hash hash_type;
+
+	// opens path if it holds a table, otherwise creates one with room for capacity slots
+	persistent_lookup_table(std::string const& path, std::size_t capacity, unsigned num_stripes = 1024,
+		Hash const& hasher_ = Hash()) : stripes(num_stripes), hasher(hasher_) {
+		try {
+			map_file(path, capacity);
+		}
+		catch (...) {
+			close();
+			throw;
+		}
+		if (reopened_existing && !header->clean_shutdown) {
+			recover();
+		}
+		header->clean_shutdown = 0;
+		attached = true;
+	}
+
+	~persistent_lookup_table() {
+		close();
+	}
+
+	persistent_lookup_table(persistent_lookup_table const& other) = delete;
+	persistent_lookup_table& operator=(persistent_lookup_table const& other) = delete;
+
+	bool reopened() const {
+		return reopened_existing;
+	}
+
+	std::size_t size() const {
+		return size_counter().load(std::memory_order_relaxed);
+	}
+
+	std::size_t capacity() const {
+		return mask + 1;
+	}
+
+	Value value_for(Key const& key, Value const& default_value = Value()) const {
+		std::size_t const hash = hasher(key);
+		std::shared_lock<std::shared_mutex> lock(stripe_for(hash));
+		slot const* const found = find_slot(key, hash);
+		return found ? found->value : default_value;
+	}
+
+	void add_or_update_mapping(Key const& key, Value const& value) {
+		std::size_t const hash = hasher(key);
+		std::unique_lock<std::shared_mutex> lock(stripe_for(hash));
+		if (slot* const found = find_slot(key, hash)) {
+			found->value = value;
+			return;
+		}
+		// claim the first free slot; keys from other stripes may race us for it
+		for (std::size_t probe = 0, i = hash & mask; probe <= mask; ++probe, i = (i + 1) & mask) {
+			std::uint32_t state = state_of(slots[i]).load(std::memory_order_relaxed);
+			while (state == empty || state == deleted) {
+				if (state_of(slots[i]).compare_exchange_weak(state, busy, std::memory_order_acquire, std::memory_order_relaxed)) {
+					hash_of(slots[i]).store(hash, std::memory_order_relaxed);
+					slots[i].key = key;
+					slots[i].value = value;
+					state_of(slots[i]).store(full, std::memory_order_release);
+					size_counter().fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+			}
+		}
+		throw std::length_error("persistent_lookup_table is full");
+	}
+
+	void remove_mapping(Key const& key) {
+		std::size_t const hash = hasher(key);
+		std::unique_lock<std::shared_mutex> lock(stripe_for(hash));
+		if (slot* const found = find_slot(key, hash)) {
+			state_of(*found).store(deleted, std::memory_order_release);
+			size_counter().fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	// cold start: spread the inserts over num_threads workers
+	void bulk_load(std::span<std::pair<Key, Value> const> entries, unsigned num_threads = std::thread::hardware_concurrency()) {
+		num_threads = std::max(1u, num_threads);
+		std::size_t const chunk = (entries.size() + num_threads - 1) / num_threads;
+		std::vector<std::jthread> threads;
+		for (unsigned t = 0; t < num_threads; ++t) {
+			std::size_t const first = std::min(entries.size(), t * chunk);
+			std::size_t const last = std::min(entries.size(), first + chunk);
+			threads.emplace_back([this, entries, first, last]() {
+				for (std::size_t i = first; i < last; ++i) {
+					add_or_update_mapping(entries[i].first, entries[i].second);
+				}
+				});
+		}
+	}
+
+	void flush() {
+		if (::msync(mapping, mapping_size, MS_SYNC) != 0) {
+			throw_errno("msync");
+		}
+	}
+};
+
+struct point {
+	std::int32_t x;
+	std::int32_t y;
+};
+
+int main(int argc, char* argv[]) {
+	std::string const path = (std::filesystem::temp_directory_path() / "persistent_lookup_table.bin").string();
+	std::filesystem::remove(path);
+
+	{
+		persistent_lookup_table<std::uint32_t, point> table(path, 1024);
+		assert(!table.reopened());
+
+		std::thread t1([&]() {
+			for (std::uint32_t i = 0; i < 300; ++i)
+				table.add_or_update_mapping(i, point{ std::int32_t(i), -std::int32_t(i) });
+			});
+		std::thread t2([&]() {
+			for (std::uint32_t i = 300; i < 600; ++i)
+				table.add_or_update_mapping(i, point{ std::int32_t(i), -std::int32_t(i) });
+			});
+		t1.join();
+		t2.join();
+
+		table.remove_mapping(50);
+		table.add_or_update_mapping(150, point{ 1, 2 });
+		table.flush();
+	}
+	{
+		persistent_lookup_table<std::uint32_t, point> table(path, 1024);
+		assert(table.reopened());
+		assert(table.size() == 599);
+		assert(table.value_for(50, point{ -1, -1 }).x == -1);
+		assert(table.value_for(150).y == 2);
+		assert(table.value_for(599).y == -599);
+		table.add_or_update_mapping(50, point{ 5, 5 });
+		assert(table.value_for(50).x == 5);
+	}
+	bool rejected = false;
+	try {
+		persistent_lookup_table<std::uint64_t, point> wrong(path, 1024);
+	}
+	catch (std::runtime_error const&) {
+		rejected = true;
+	}
+	assert(rejected);
+	std::filesystem::remove(path);
+
+	std::println("Test passed!");
+
+	// pass the entry count as the first argument, e.g. 100000000
+	std::size_t const num_entries = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	using clock = std::chrono::high_resolution_clock;
+
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> entries;
+	entries.reserve(num_entries);
+	for (std::uint64_t i = 0; i < num_entries; ++i) {
+		entries.emplace_back(i * 2654435761u, i);
+	}
+
+	auto cold_start = clock::now();
+	{
+		persistent_lookup_table<std::uint64_t, std::uint64_t> table(path, num_entries * 2);
+		table.bulk_load(entries);
+		auto cold_first = clock::now();
+		assert(table.value_for(entries[num_entries / 2].first) == num_entries / 2);
+		std::println("cold build of {} entries: time to first lookup {}", num_entries,
+			std::chrono::duration_cast<std::chrono::milliseconds>(cold_first - cold_start));
+		table.flush();
+	}
+
+	auto warm_start = clock::now();
+	{
+		persistent_lookup_table<std::uint64_t, std::uint64_t> table(path, 0);
+		std::uint64_t const value = table.value_for(entries[num_entries / 2].first);
+		auto warm_first = clock::now();
+		assert(table.reopened() && value == num_entries / 2);
+		(void)value;
+		std::println("warm reopen of {} entries: time to first lookup {}", table.size(),
+			std::chrono::duration_cast<std::chrono::microseconds>(warm_first - warm_start));
+
+		auto scan_start = clock::now();
+		for (std::size_t i = 0; i < num_entries; i += 97) {
+			[[maybe_unused]] std::uint64_t const v = table.value_for(entries[i].first);
+			assert(v == i);
+		}
+		auto scan_end = clock::now();
+		std::println("warm reopen: {} scattered lookups in {}", num_entries / 97 + 1,
+			std::chrono::duration_cast<std::chrono::milliseconds>(scan_end - scan_start));
+	}
+	std::filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+struct close_queue {};
+
+// Helper for visit (Overload pattern)
+template<class... Ts>
+struct overloaded : Ts... {
+	using Ts::operator()...;
+};
+
+// Listing 6.11 layout, the locked baseline
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class threadsafe_lookup_table {
+private:
+	class bucket_type {
+	private:
+		typedef std::pair<Key, Value> bucket_value;
+		typedef std::list<bucket_value> bucket_data;
+		typedef typename bucket_data::iterator bucket_iterator;
+		bucket_data data;
+		mutable std::shared_mutex mutex;
+		bucket_iterator find_entry_for(Key const& key) {
+			return std::find_if(data.begin(), data.end(), [&](bucket_value const& item) { return item.first == key; });
+		}
+	public:
+		Value value_for(Key const& key, Value const& default_value) {
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			return (found_entry == data.end()) ? default_value : found_entry->second;
+		}
+
+		void add_or_update_mapping(Key const& key, Value const& value) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry == data.end()) {
+				data.push_back(bucket_value(key, value));
+			}
+			else {
+				found_entry->second = value;
+			}
+		}
+	};
+
+	std::vector<std::unique_ptr<bucket_type>> buckets;
+	Hash hasher;
+
+	bucket_type& get_bucket(Key const& key) {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		return *buckets[bucket_index];
+	}
+
+public:
+	threadsafe_lookup_table(unsigned num_buckets = 19, Hash const& hasher_ = Hash()) : buckets(num_buckets), hasher(hasher_) {
+		for (unsigned i = 0; i < num_buckets; ++i) {
+			buckets[i].reset(new bucket_type);
+		}
+	}
+
+	threadsafe_lookup_table(threadsafe_lookup_table const& other) = delete;
+	threadsafe_lookup_table& operator=(threadsafe_lookup_table const& other) = delete;
+
+	Value value_for(Key const& key, Value const& default_value = Value()) {
+		return get_bucket(key).value_for(key, default_value);
+	}
+
+	void add_or_update_mapping(Key const& key, Value const& value) {
+		get_bucket(key).add_or_update_mapping(key, value);
+	}
+};
+
+// Single producer, single consumer ring; head and tail live on separate cache lines
+template<typename T, std::size_t Capacity>
+class spsc_mailbox {
+	std::array<T, Capacity> slots;
+	alignas(std::hardware_destructive_interference_size) std::atomic<std::size_t> head{ 0 };
+	alignas(std::hardware_destructive_interference_size) std::atomic<std::size_t> tail{ 0 };
+public:
+	// moves from value only when there was room
+	bool try_push(T& value) {
+		std::size_t const t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+		slots[t % Capacity] = std::move(value);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop(T& value) {
+		std::size_t const h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = std::move(slots[h % Capacity]);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+// Shared-nothing map: shard i is a plain unordered_map touched only by its pinned owner
+// thread. Clients batch requests per shard and hand the batches over through one SPSC
+// mailbox per (client, shard) pair, so no lock is taken anywhere on the data path.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class sharded_lookup_table {
+private:
+	struct put_request {
+		Key key;
+		Value value;
+	};
+
+	struct remove_request {
+		Key key;
+	};
+
+	struct get_request {
+		Key key;
+		Value default_value;
+		std::promise<Value> reply;
+	};
+
+	struct sync_request {
+		std::promise<void> done;
+	};
+
+	using Message = std::variant<close_queue, put_request, remove_request, get_request, sync_request>;
+	using batch = std::vector<Message>;
+	static constexpr std::size_t mailbox_capacity = 64;
+
+	struct shard {
+		// one mailbox per client plus a control mailbox for shutdown
+		std::vector<std::unique_ptr<spsc_mailbox<batch, mailbox_capacity>>> mailboxes;
+		std::atomic<std::uint32_t> doorbell{ 0 };
+		std::thread owner;
+	};
+
+	std::vector<std::unique_ptr<shard>> shards;
+	unsigned const max_clients;
+	std::atomic<unsigned> connected_clients{ 0 };
+	Hash hasher;
+
+	unsigned shard_for(Key const& key) const {
+		return unsigned(hasher(key) % shards.size());
+	}
+
+	void post(unsigned shard_index, unsigned mailbox, batch& messages) {
+		shard& s = *shards[shard_index];
+		while (!s.mailboxes[mailbox]->try_push(messages)) {
+			std::this_thread::yield();
+		}
+		s.doorbell.fetch_add(1, std::memory_order_release);
+		s.doorbell.notify_one();
+	}
+
+	static void pin_to_core(std::thread& t, unsigned core) {
+		unsigned const concurrency = std::max(1u, std::thread::hardware_concurrency());
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(core % concurrency, &cpus);
+		pthread_setaffinity_np(t.native_handle(), sizeof(cpus), &cpus);
+	}
+
+	static void run_owner(shard& s) {
+		std::unordered_map<Key, Value, Hash> data;
+		batch messages;
+		try {
+			while (true) {
+				// read the doorbell before scanning, so a post after the scan wakes us
+				std::uint32_t const seen = s.doorbell.load(std::memory_order_acquire);
+				bool found = false;
+				for (auto& mailbox : s.mailboxes) {
+					while (mailbox->try_pop(messages)) {
+						found = true;
+						for (Message& msg : messages) {
+							std::visit(overloaded{
+								[&](close_queue const&) { throw close_queue(); },
+								[&](put_request& request) { data.insert_or_assign(std::move(request.key), std::move(request.value)); },
+								[&](remove_request& request) { data.erase(request.key); },
+								[&](get_request& request) {
+									auto const it = data.find(request.key);
+									request.reply.set_value(it == data.end() ? request.default_value : it->second);
+								},
+								[&](sync_request& request) { request.done.set_value(); }
+								}, msg);
+						}
+					}
+				}
+				if (!found) {
+					s.doorbell.wait(seen, std::memory_order_acquire);
+				}
+			}
+		}
+		catch (close_queue const&) {}
+	}
+
+public:
+	typedef Key key_type;
+	typedef Value mapped_type;
+	typedef Hash hash_type;
+
+	// Per-thread handle: it owns the producer side of one mailbox in every shard
+	class client {
+		sharded_lookup_table* table;
+		unsigned id;
+		std::size_t batch_size;
+		std::vector<batch> pending;
+
+		void send(unsigned shard_index, Message msg) {
+			pending[shard_index].push_back(std::move(msg));
+			if (pending[shard_index].size() >= batch_size) {
+				flush(shard_index);
+			}
+		}
+
+		void flush(unsigned shard_index) {
+			if (!pending[shard_index].empty()) {
+				table->post(shard_index, id, pending[shard_index]);
+				pending[shard_index] = batch();
+				pending[shard_index].reserve(batch_size);
+			}
+		}
+
+	public:
+		client(sharded_lookup_table& table_, unsigned id_, std::size_t batch_size_) :
+			table(&table_), id(id_), batch_size(batch_size_), pending(table_.shards.size()) {}
+
+		client(client const& other) = delete;
+		client& operator=(client const& other) = delete;
+		client(client&& other) = default;
+
+		~client() {
+			if (table) {
+				flush();
+			}
+		}
+
+		// applied asynchronously, in order with this client's other requests to the same shard
+		void add_or_update_mapping(Key const& key, Value const& value) {
+			send(table->shard_for(key), put_request{ key, value });
+		}
+
+		void remove_mapping(Key const& key) {
+			send(table->shard_for(key), remove_request{ key });
+		}
+
+		std::future<Value> value_for(Key const& key, Value const& default_value = Value()) {
+			unsigned const shard_index = table->shard_for(key);
+			std::promise<Value> reply;
+			std::future<Value> result = reply.get_future();
+			send(shard_index, get_request{ key, default_value, std::move(reply) });
+			flush(shard_index);
+			return result;
+		}
+
+		void flush() {
+			for (unsigned i = 0; i < pending.size(); ++i) {
+				flush(i);
+			}
+		}
+
+		// returns once every shard has applied everything this client sent before the call
+		void sync() {
+			std::vector<std::future<void>> acks;
+			for (unsigned i = 0; i < pending.size(); ++i) {
+				std::promise<void> done;
+				acks.push_back(done.get_future());
+				send(i, sync_request{ std::move(done) });
+				flush(i);
+			}
+			for (auto& ack : acks) {
+				ack.wait();
+			}
+		}
+	};
+
+	sharded_lookup_table(unsigned num_shards, unsigned max_clients_, Hash const& hasher_ = Hash()) :
+		max_clients(max_clients_), hasher(hasher_) {
+		for (unsigned i = 0; i < num_shards; ++i) {
+			auto s = std::make_unique<shard>();
+			for (unsigned j = 0; j <= max_clients; ++j) {
+				s->mailboxes.push_back(std::make_unique<spsc_mailbox<batch, mailbox_capacity>>());
+			}
+			shards.push_back(std::move(s));
+		}
+		for (unsigned i = 0; i < num_shards; ++i) {
+			shards[i]->owner = std::thread(&sharded_lookup_table::run_owner, std::ref(*shards[i]));
+			pin_to_core(shards[i]->owner, i);
+		}
+	}
+
+	~sharded_lookup_table() {
+		for (unsigned i = 0; i < shards.size(); ++i) {
+			batch stop;
+			stop.push_back(close_queue());
+			post(i, max_clients, stop);
+		}
+		for (auto& s : shards) {
+			s->owner.join();
+		}
+	}
+
+	sharded_lookup_table(sharded_lookup_table const& other) = delete;
+	sharded_lookup_table& operator=(sharded_lookup_table const& other) = delete;
+
+	client connect(std::size_t batch_size = 32) {
+		unsigned const id = connected_clients.fetch_add(1, std::memory_order_relaxed);
+		if (id >= max_clients) {
+			throw std::length_error("too many clients for sharded_lookup_table");
+		}
+		return client(*this, id, batch_size);
+	}
+};
+
+void benchmark_writes(std::string const& workload, int num_keys) {
+	const int num_threads = 4;
+	const int writes_per_thread = 500000;
+
+	auto key_for = [num_keys](std::mt19937& gen) {
+		return std::uniform_int_distribution<int>(0, num_keys - 1)(gen);
+	};
+
+	{
+		threadsafe_lookup_table<int, int> table(65537);
+		std::vector<std::thread> threads;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 gen(t);
+				for (int i = 0; i < writes_per_thread; ++i) {
+					table.add_or_update_mapping(key_for(gen), i);
+				}
+				});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		std::println("{:<22} locked table:  {}", workload, std::chrono::duration_cast<std::chrono::milliseconds>(end - start));
+	}
+	{
+		unsigned const concurrency = std::thread::hardware_concurrency();
+		unsigned const num_shards = (concurrency > 0) ? concurrency : 2;
+		sharded_lookup_table<int, int> table(num_shards, num_threads);
+		std::vector<std::thread> threads;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&, t]() {
+				auto client = table.connect(64);
+				std::mt19937 gen(t);
+				for (int i = 0; i < writes_per_thread; ++i) {
+					client.add_or_update_mapping(key_for(gen), i);
+				}
+				client.sync();
+				});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		std::println("{:<22} sharded ({} owners): {}", workload, num_shards,
+			std::chrono::duration_cast<std::chrono::milliseconds>(end - start));
+	}
+}
+
+int main() {
+	{
+		sharded_lookup_table<int, std::string> table(3, 3);
+
+		std::thread t1([&]() {
+			auto client = table.connect();
+			for (int i = 0; i < 100; ++i)
+				client.add_or_update_mapping(i, "Value " + std::to_string(i));
+			client.sync();
+			});
+
+		std::thread t2([&]() {
+			auto client = table.connect();
+			for (int i = 100; i < 200; ++i)
+				client.add_or_update_mapping(i, "Value " + std::to_string(i));
+			client.sync();
+			});
+
+		t1.join();
+		t2.join();
+
+		auto client = table.connect();
+		assert(client.value_for(50, "default").get() == "Value 50");
+		assert(client.value_for(150, "default").get() == "Value 150");
+		client.remove_mapping(50);
+		assert(client.value_for(50, "default").get() == "default");
+
+		bool rejected = false;
+		try {
+			auto extra = table.connect();
+		}
+		catch (std::length_error const&) {
+			rejected = true;
+		}
+		assert(rejected);
+	}
+
+	std::println("Test passed!");
+
+	benchmark_writes("uniform, 100000 keys", 100000);
+	benchmark_writes("hot, 16 keys", 16);
+	return 0;
+}
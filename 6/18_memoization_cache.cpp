@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Converts to the factory's result, so the mapped value is built directly in the list node
+template<typename Factory>
+struct deferred_value {
+	Factory& factory;
+	operator std::invoke_result_t<Factory&>() const {
+		return factory();
+	}
+};
+
+// Listing 6.11 table with compute_if_absent
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class threadsafe_lookup_table {
+private:
+	class bucket_type {
+	private:
+		typedef std::pair<Key, Value> bucket_value;
+		typedef std::list<bucket_value> bucket_data;
+		typedef typename bucket_data::iterator bucket_iterator;
+		bucket_data data;
+		mutable std::shared_mutex mutex;
+		bucket_iterator find_entry_for(Key const& key) {
+			return std::find_if(data.begin(), data.end(), [&](bucket_value const& item) { return item.first == key; });
+		}
+	public:
+		Value value_for(Key const& key, Value const& default_value) {
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			return (found_entry == data.end()) ? default_value : found_entry->second;
+		}
+
+		void add_or_update_mapping(Key const& key, Value const& value) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry == data.end()) {
+				data.push_back(bucket_value(key, value));
+			}
+			else {
+				found_entry->second = value;
+			}
+		}
+
+		void remove_mapping(Key const& key) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry != data.end()) {
+				data.erase(found_entry);
+			}
+		}
+
+		template<typename Predicate>
+		bool remove_mapping_if(Key const& key, Predicate& p) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry == data.end() || !p(std::as_const(found_entry->second))) {
+				return false;
+			}
+			data.erase(found_entry);
+			return true;
+		}
+
+		template<typename Factory>
+		Value compute_if_absent(Key const& key, Factory& factory) {
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			bucket_iterator const found_entry = find_entry_for(key);
+			if (found_entry != data.end()) {
+				return found_entry->second;
+			}
+			data.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+				std::forward_as_tuple(deferred_value<Factory>{ factory }));
+			return data.back().second;
+		}
+	};
+
+	std::vector<std::unique_ptr<bucket_type>> buckets;
+	Hash hasher;
+
+	bucket_type& get_bucket(Key const& key) {
+		std::size_t const bucket_index = hasher(key) % buckets.size();
+		return *buckets[bucket_index];
+	}
+
+public:
+	typedef Key key_type;
+	typedef Value mapped_type;
+	typedef Hash hash_type;
+
+	threadsafe_lookup_table(unsigned num_buckets = 19, Hash const& hasher_ = Hash()) : buckets(num_buckets), hasher(hasher_) {
+		for (unsigned i = 0; i < num_buckets; ++i) {
+			buckets[i].reset(new bucket_type);
+		}
+	}
+
+	threadsafe_lookup_table(threadsafe_lookup_table const& other) = delete;
+	threadsafe_lookup_table& operator=(threadsafe_lookup_table const& other) = delete;
+
+	Value value_for(Key const& key, Value const& default_value = Value()) {
+		return get_bucket(key).value_for(key, default_value);
+	}
+
+	void add_or_update_mapping(Key const& key, Value const& value) {
+		get_bucket(key).add_or_update_mapping(key, value);
+	}
+
+	void remove_mapping(Key const& key) {
+		get_bucket(key).remove_mapping(key);
+	}
+
+	// removes the mapping only if p accepts its current value, checked under the bucket lock
+	template<typename Predicate> requires std::predicate<Predicate&, Value const&>
+	bool remove_mapping_if(Key const& key, Predicate p) {
+		return get_bucket(key).remove_mapping_if(key, p);
+	}
+
+	// factory runs at most once per absent key, under the bucket lock
+	template<typename Factory> requires std::convertible_to<std::invoke_result_t<Factory&>, Value>
+	Value compute_if_absent(Key const& key, Factory factory) {
+		return get_bucket(key).compute_if_absent(key, factory);
+	}
+};
+
+// std::call_once per key: the first caller installs an in-flight shared_future under the
+// bucket lock and computes outside it; everyone else blocks on that future.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class memoization_cache {
+	// shared_futures can't be compared, so each installed entry carries a ticket instead
+	struct in_flight {
+		std::shared_future<Value> result;
+		std::uint64_t ticket;
+	};
+
+	threadsafe_lookup_table<Key, in_flight, Hash> table;
+	std::atomic<std::uint64_t> next_ticket{ 0 };
+public:
+	explicit memoization_cache(unsigned num_buckets = 19) : table(num_buckets) {}
+
+	memoization_cache(memoization_cache const& other) = delete;
+	memoization_cache& operator=(memoization_cache const& other) = delete;
+
+	template<typename Function> requires std::convertible_to<std::invoke_result_t<Function&, Key const&>, Value>
+	Value get_or_compute(Key const& key, Function fn) {
+		std::promise<Value> promise;
+		bool computing = false;
+		in_flight const entry = table.compute_if_absent(key, [&]() {
+			computing = true;
+			return in_flight{ promise.get_future().share(), next_ticket.fetch_add(1, std::memory_order_relaxed) };
+			});
+		if (computing) {
+			try {
+				promise.set_value(fn(key));
+			}
+			catch (...) {
+				// current waiters see the exception, the next caller gets to retry; if the key
+				// was invalidated and someone else's computation installed meanwhile, leave it be
+				table.remove_mapping_if(key, [&](in_flight const& current) { return current.ticket == entry.ticket; });
+				promise.set_exception(std::current_exception());
+			}
+		}
+		return entry.result.get();
+	}
+
+	void invalidate(Key const& key) {
+		table.remove_mapping(key);
+	}
+};
+
+// check-then-compute without single flight: every thread that misses computes
+template<typename Key, typename Value>
+class naive_memoization_cache {
+	threadsafe_lookup_table<Key, std::shared_ptr<Value const>> table;
+public:
+	template<typename Function>
+	Value get_or_compute(Key const& key, Function fn) {
+		if (std::shared_ptr<Value const> const cached = table.value_for(key)) {
+			return *cached;
+		}
+		auto const value = std::make_shared<Value const>(fn(key));
+		table.add_or_update_mapping(key, value);
+		return *value;
+	}
+};
+
+std::atomic<int> computations{ 0 };
+
+long expensive_computation(int const& key) {
+	computations.fetch_add(1, std::memory_order_relaxed);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	return long(key) * key;
+}
+
+template <typename T>
+void run_benchmark(const std::string& name) {
+	T cache;
+	const int num_threads = 64;
+	const int num_hot_keys = 8;
+	const int requests_per_thread = 10000;
+	computations.store(0);
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < num_threads; ++i) {
+		threads.emplace_back([&cache, i]() {
+			for (int j = 0; j < requests_per_thread; ++j) {
+				int const key = (i + j) % num_hot_keys;
+				long const value = cache.get_or_compute(key, expensive_computation);
+				assert(value == long(key) * key);
+				(void)value;
+			}
+			});
+	}
+	for (auto& t : threads)
+		t.join();
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("{}: {:.1f} ms, {} computations for {} keys", name, duration.count(), computations.load(), num_hot_keys);
+}
+
+int main() {
+	memoization_cache<int, long> cache;
+	computations.store(0);
+	{
+		std::vector<std::jthread> herd;
+		for (int i = 0; i < 16; ++i) {
+			herd.emplace_back([&cache]() {
+				assert(cache.get_or_compute(7, expensive_computation) == 49);
+				});
+		}
+	}
+	assert(computations.load() == 1);
+
+	bool failed = false;
+	try {
+		cache.get_or_compute(8, [](int const&) -> long { throw std::runtime_error("backend down"); });
+	}
+	catch (std::runtime_error const&) {
+		failed = true;
+	}
+	assert(failed);
+	assert(cache.get_or_compute(8, expensive_computation) == 64);
+
+	// a failing computation must not remove the entry installed after an invalidate
+	failed = false;
+	try {
+		cache.get_or_compute(9, [&cache](int const&) -> long {
+			cache.invalidate(9);
+			std::jthread([&cache]() { cache.get_or_compute(9, expensive_computation); }).join();
+			throw std::runtime_error("backend down");
+			});
+	}
+	catch (std::runtime_error const&) {
+		failed = true;
+	}
+	assert(failed);
+	assert(cache.get_or_compute(9, expensive_computation) == 81);
+
+	cache.invalidate(7);
+	assert(cache.get_or_compute(7, expensive_computation) == 49);
+	assert(computations.load() == 4);
+
+	std::println("Test passed!");
+
+	run_benchmark<naive_memoization_cache<int, long>>("Naive (value_for, then compute)");
+	run_benchmark<memoization_cache<int, long>>("Single flight (shared_future)");
+	return 0;
+}
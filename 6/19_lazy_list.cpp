@@ -0,0 +1,336 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Listing 6.13, the hand-over-hand baseline
+template<typename T>
+class threadsafe_list {
+	struct node {
+		std::mutex m;
+		std::shared_ptr<T> data;
+		std::unique_ptr<node> next;
+		node() : next() {}
+		node(T const& value) : data(std::make_shared<T>(value)) {}
+	};
+	node head;
+public:
+	threadsafe_list() {}
+
+	~threadsafe_list() {
+		remove_if([](T const&) {return true; });
+	}
+
+	threadsafe_list(threadsafe_list const& other) = delete;
+
+	threadsafe_list& operator=(threadsafe_list const& other) = delete;
+
+	void push_front(T const& value) {
+		std::unique_ptr<node> new_node(new node(value));
+		std::lock_guard<std::mutex> lk(head.m);
+		new_node->next = std::move(head.next);
+		head.next = std::move(new_node);
+	}
+
+	template<typename Function> requires std::invocable<Function, T&>
+	void for_each(Function f) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get())
+		{
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			f(*next->data);
+			current = next;
+			lk = std::move(next_lk);
+		}
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	std::shared_ptr<T> find_first_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			if (p(*next->data)) {
+				return next->data;
+			}
+			current = next;
+			lk = std::move(next_lk);
+		}
+		return std::shared_ptr<T>();
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			if (p(*next->data)) {
+				std::unique_ptr<node> old_next = std::move(current->next);
+				current->next = std::move(next->next);
+				next_lk.unlock();
+			}
+			else {
+				lk.unlock();
+				current = next;
+				lk = std::move(next_lk);
+			}
+		}
+	}
+};
+
+// Lazy synchronization: traversals follow atomic next pointers without locking and skip
+// marked nodes. remove_if locks only the predecessor and the victim, validates that
+// neither is marked and that they are still adjacent, then marks and unlinks.
+// Unlinked nodes are freed once no traversal can still be standing on them, using the
+// threads-in-pop counting scheme from the lock-free stack (Listing 7.5).
+template<typename T>
+class lazy_list {
+	struct node {
+		std::mutex m;
+		std::shared_ptr<T> data;
+		std::atomic<node*> next{ nullptr };
+		std::atomic<bool> marked{ false };
+		node* next_retired = nullptr;
+		node() {}
+		node(T const& value) : data(std::make_shared<T>(value)) {}
+	};
+
+	node head;
+	std::atomic<unsigned> traversals{ 0 };
+	std::atomic<node*> to_be_deleted{ nullptr };
+
+	struct traversal_guard {
+		lazy_list& list;
+		explicit traversal_guard(lazy_list& list_) : list(list_) {
+			++list.traversals;
+		}
+		~traversal_guard() {
+			--list.traversals;
+		}
+	};
+
+	static void delete_nodes(node* nodes) {
+		while (nodes) {
+			node* const next = nodes->next_retired;
+			delete nodes;
+			nodes = next;
+		}
+	}
+
+	void chain_pending_nodes(node* first) {
+		if (!first) {
+			return;
+		}
+		node* last = first;
+		while (node* const next = last->next_retired) {
+			last = next;
+		}
+		last->next_retired = to_be_deleted;
+		while (!to_be_deleted.compare_exchange_weak(last->next_retired, first));
+	}
+
+	// called by a remover that still counts as a traversal
+	void try_reclaim(node* retired) {
+		if (traversals == 1) {
+			node* const nodes_to_delete = to_be_deleted.exchange(nullptr);
+			if (!--traversals) {
+				delete_nodes(nodes_to_delete);
+			}
+			else {
+				chain_pending_nodes(nodes_to_delete);
+			}
+			delete_nodes(retired);
+		}
+		else {
+			chain_pending_nodes(retired);
+			--traversals;
+		}
+	}
+
+public:
+	lazy_list() {}
+
+	~lazy_list() {
+		node* current = head.next;
+		while (current) {
+			node* const next = current->next;
+			delete current;
+			current = next;
+		}
+		delete_nodes(to_be_deleted);
+	}
+
+	lazy_list(lazy_list const& other) = delete;
+
+	lazy_list& operator=(lazy_list const& other) = delete;
+
+	void push_front(T const& value) {
+		node* const new_node = new node(value);
+		std::lock_guard<std::mutex> lk(head.m);
+		new_node->next = head.next.load();
+		head.next = new_node;
+	}
+
+	// elements are shared with concurrent traversals, so they are only handed out as const
+	template<typename Function> requires std::invocable<Function, T const&>
+	void for_each(Function f) {
+		traversal_guard guard(*this);
+		for (node* current = head.next; current; current = current->next) {
+			if (!current->marked) {
+				f(std::as_const(*current->data));
+			}
+		}
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	std::shared_ptr<T> find_first_if(Predicate p) {
+		traversal_guard guard(*this);
+		for (node* current = head.next; current; current = current->next) {
+			if (!current->marked && p(std::as_const(*current->data))) {
+				return current->data;
+			}
+		}
+		return std::shared_ptr<T>();
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		++traversals;
+		node* retired = nullptr;
+		try {
+			node* previous = &head;
+			node* current = head.next;
+			while (current) {
+				if (current->marked || !p(std::as_const(*current->data))) {
+					previous = current;
+					current = current->next;
+					continue;
+				}
+				std::scoped_lock lk(previous->m, current->m);
+				if (previous->marked || current->marked || previous->next != current) {
+					// lost a race with another remover; start over from the head
+					previous = &head;
+					current = head.next;
+					continue;
+				}
+				current->marked = true;
+				previous->next = current->next.load();
+				current->next_retired = retired;
+				retired = current;
+				current = previous->next;
+			}
+		}
+		catch (...) {
+			try_reclaim(retired);
+			throw;
+		}
+		try_reclaim(retired);
+	}
+};
+
+template<typename List>
+void data_producer(List& list) {
+	for (int i = 0; i < 100; ++i) {
+		list.push_front(i);
+	}
+}
+
+template<typename List>
+void data_cleaner(List& list) {
+	// remove all even numbers
+	list.remove_if([](int const& val) {
+		return val % 2 == 0;
+		});
+}
+
+// readers scan a 10K-element list while one writer keeps inserting and removing
+template<typename List>
+void run_benchmark(std::string const& name) {
+	List list;
+	const int num_elements = 10000;
+	const int num_readers = 4;
+	const int scans_per_reader = 200;
+	for (int i = 0; i < num_elements; ++i) {
+		list.push_front(i);
+	}
+
+	std::atomic<bool> readers_done{ false };
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < num_readers; ++r) {
+		threads.emplace_back([&list]() {
+			for (int i = 0; i < scans_per_reader; ++i) {
+				long sum = 0;
+				list.for_each([&sum](int const& val) { sum += val; });
+				auto const found = list.find_first_if([](int const& val) { return val == 0; });
+				assert(sum > 0);
+				(void)found;
+			}
+			});
+	}
+	std::thread writer([&list, &readers_done]() {
+		int next = -1;
+		while (!readers_done.load()) {
+			list.push_front(next);
+			list.remove_if([next](int const& val) { return val == next; });
+			--next;
+		}
+		});
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	readers_done.store(true);
+	writer.join();
+
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("{}: {} readers x {} scans of {} elements in {:.1f} ms",
+		name, num_readers, scans_per_reader, num_elements, duration.count());
+}
+
+int main() {
+	lazy_list<int> list;
+
+	{
+		std::jthread t1(data_producer<lazy_list<int>>, std::ref(list));
+		std::jthread t2(data_producer<lazy_list<int>>, std::ref(list));
+
+		// the exact count below needs every push done before the cleaner runs
+		t1.join();
+		t2.join();
+
+		std::jthread t3(data_cleaner<lazy_list<int>>, std::ref(list));
+		std::jthread t4([&list]() {
+			int count = 0;
+			list.for_each([&count](int const&) { count++; });
+			assert(count <= 200);
+			});
+	}
+
+	int count = 0;
+	list.for_each([&count](int const& val) {
+		assert(val % 2 == 1);
+		count++;
+		});
+
+	assert(count == 100);
+	assert(list.find_first_if([](int const& val) { return val == 99; }));
+	assert(!list.find_first_if([](int const& val) { return val == 98; }));
+	std::println("Test passed!");
+
+	run_benchmark<threadsafe_list<int>>("hand-over-hand threadsafe_list");
+	run_benchmark<lazy_list<int>>("lazy_list");
+	return 0;
+}
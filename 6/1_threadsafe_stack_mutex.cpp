@@ -8,6 +8,8 @@
 #include <thread>
 #include <vector>
 
+#include "sharded_counter.h"
+
 struct empty_stack : std::exception {
 	const char* what() const noexcept override {
 		return "empty stack";
@@ -56,14 +58,14 @@ public:
 };
 
 
-std::atomic<int> push_count{ 0 };
-std::atomic<int> pop_count{ 0 };
+sharded_counter push_count;
+sharded_counter pop_count;
 std::atomic<bool> producers_finished{ false };
 
 void producer(threadsafe_stack<int>& stack, int id, int items_to_push) {
 	for (int i = 0; i < items_to_push; ++i) {
 		stack.push(i);
-		push_count.fetch_add(1, std::memory_order_relaxed);
+		push_count.add(1);
 	}
 	std::println("Producer {} finished", id);
 }
@@ -73,7 +75,7 @@ void consumer(threadsafe_stack<int>& stack, int id) {
 		try {
 			int value;
 			stack.pop(value);
-			pop_count.fetch_add(1, std::memory_order_relaxed);
+			pop_count.add(1);
 		}
 		catch (const empty_stack&) {
 			if (producers_finished.load(std::memory_order_acquire)) {
@@ -121,10 +123,10 @@ int main() {
 	}
 
 	std::println("Test finished.");
-	std::println("Total pushed: {}", push_count.load());
-	std::println("Total popped: {}", pop_count.load());
+	std::println("Total pushed: {}", push_count.read());
+	std::println("Total popped: {}", pop_count.read());
 
-	assert(push_count == pop_count);
+	assert(push_count.read() == pop_count.read());
 	assert(ts_stack.empty());
 
 	return 0;
@@ -0,0 +1,306 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "epoch_reclamation.h"
+
+// Listing 6.13, the hand-over-hand baseline
+template<typename T>
+class threadsafe_list {
+	struct node {
+		std::mutex m;
+		std::shared_ptr<T> data;
+		std::unique_ptr<node> next;
+		node() : next() {}
+		node(T const& value) : data(std::make_shared<T>(value)) {}
+	};
+	node head;
+public:
+	threadsafe_list() {}
+
+	~threadsafe_list() {
+		remove_if([](T const&) {return true; });
+	}
+
+	threadsafe_list(threadsafe_list const& other) = delete;
+
+	threadsafe_list& operator=(threadsafe_list const& other) = delete;
+
+	void push_front(T const& value) {
+		std::unique_ptr<node> new_node(new node(value));
+		std::lock_guard<std::mutex> lk(head.m);
+		new_node->next = std::move(head.next);
+		head.next = std::move(new_node);
+	}
+
+	template<typename Function> requires std::invocable<Function, T&>
+	void for_each(Function f) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get())
+		{
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			f(*next->data);
+			current = next;
+			lk = std::move(next_lk);
+		}
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	std::shared_ptr<T> find_first_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			if (p(*next->data)) {
+				return next->data;
+			}
+			current = next;
+			lk = std::move(next_lk);
+		}
+		return std::shared_ptr<T>();
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			if (p(*next->data)) {
+				std::unique_ptr<node> old_next = std::move(current->next);
+				current->next = std::move(next->next);
+				next_lk.unlock();
+			}
+			else {
+				lk.unlock();
+				current = next;
+				lk = std::move(next_lk);
+			}
+		}
+	}
+};
+
+// Harris-style list: a node is logically deleted by setting the low bit of its own next
+// pointer, then physically unlinked by a CAS on its predecessor. Readers just skip marked
+// nodes; removers unlink any they meet, and whoever wins that CAS retires the node.
+template<typename T>
+class lock_free_list {
+	struct node {
+		std::shared_ptr<T> data;
+		std::atomic<node*> next{ nullptr };
+		node(T const& value) : data(std::make_shared<T>(value)) {}
+	};
+
+	static bool is_marked(node* p) {
+		return reinterpret_cast<std::uintptr_t>(p) & 1;
+	}
+
+	static node* marked(node* p) {
+		return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(p) | 1);
+	}
+
+	static node* unmarked(node* p) {
+		return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(p) & ~std::uintptr_t(1));
+	}
+
+	std::atomic<node*> head{ nullptr };
+
+public:
+	lock_free_list() {}
+
+	~lock_free_list() {
+		node* current = head.load();
+		while (current) {
+			node* const next = unmarked(current->next.load());
+			delete current;
+			current = next;
+		}
+	}
+
+	lock_free_list(lock_free_list const& other) = delete;
+
+	lock_free_list& operator=(lock_free_list const& other) = delete;
+
+	void push_front(T const& value) {
+		node* const new_node = new node(value);
+		node* old_head = head.load();
+		do {
+			new_node->next.store(old_head);
+		} while (!head.compare_exchange_weak(old_head, new_node));
+	}
+
+	// elements are shared with concurrent traversals, so they are only handed out as const
+	template<typename Function> requires std::invocable<Function, T const&>
+	void for_each(Function f) {
+		epoch_guard guard;
+		for (node* current = head.load(); current; ) {
+			node* const next = current->next.load();
+			if (!is_marked(next)) {
+				f(std::as_const(*current->data));
+			}
+			current = unmarked(next);
+		}
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	std::shared_ptr<T> find_first_if(Predicate p) {
+		epoch_guard guard;
+		for (node* current = head.load(); current; ) {
+			node* const next = current->next.load();
+			if (!is_marked(next) && p(std::as_const(*current->data))) {
+				return current->data;
+			}
+			current = unmarked(next);
+		}
+		return std::shared_ptr<T>();
+	}
+
+	// a lost CAS restarts from the head, so p may see an element more than once
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		epoch_guard guard;
+	retry:
+		std::atomic<node*>* previous = &head;
+		node* current = previous->load();
+		while (current) {
+			node* next = current->next.load();
+			if (!is_marked(next)) {
+				if (!p(std::as_const(*current->data))) {
+					previous = &current->next;
+					current = next;
+					continue;
+				}
+				if (!current->next.compare_exchange_strong(next, marked(next))) {
+					// next changed or another remover marked it first; look again
+					goto retry;
+				}
+			}
+			if (!previous->compare_exchange_strong(current, unmarked(next))) {
+				// the predecessor was marked or unlinked meanwhile
+				goto retry;
+			}
+			guard.retire(current);
+			current = unmarked(next);
+		}
+	}
+};
+
+template<typename List>
+void data_producer(List& list) {
+	for (int i = 0; i < 100; ++i) {
+		list.push_front(i);
+	}
+}
+
+template<typename List>
+void data_cleaner(List& list) {
+	// remove all even numbers
+	list.remove_if([](int const& val) {
+		return val % 2 == 0;
+		});
+}
+
+template<typename List>
+void data_printer(List& list) {
+	int count = 0;
+	list.for_each([&count](int const&) {
+		count++;
+		});
+	std::println("Counted items: {}", count);
+}
+
+// the driver from main, scaled up: producers, a cleaner and a printer all running at once
+template<typename List>
+void run_benchmark(std::string const& name) {
+	List list;
+	const int num_producers = 2;
+	const int items_per_producer = 100000;
+	std::atomic<bool> producers_done{ false };
+	int passes = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<std::jthread> producers;
+		for (int p = 0; p < num_producers; ++p) {
+			producers.emplace_back([&list]() {
+				for (int i = 0; i < items_per_producer; ++i) {
+					list.push_front(i);
+				}
+				});
+		}
+		std::jthread cleaner([&list, &producers_done]() {
+			while (!producers_done.load()) {
+				list.remove_if([](int const& val) { return val % 2 == 0; });
+			}
+			list.remove_if([](int const& val) { return val % 2 == 0; });
+			});
+		std::jthread printer([&list, &producers_done, &passes]() {
+			while (!producers_done.load()) {
+				long sum = 0;
+				list.for_each([&sum](int const& val) { sum += val; });
+				++passes;
+			}
+			});
+		for (auto& t : producers) {
+			t.join();
+		}
+		producers_done.store(true);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	int count = 0;
+	list.for_each([&count](int const& val) {
+		assert(val % 2 == 1);
+		count++;
+		});
+	assert(count == num_producers * items_per_producer / 2);
+
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("{}: {:.1f} ms, {} printer passes", name, duration.count(), passes);
+}
+
+int main() {
+	lock_free_list<int> list;
+
+	{
+		std::jthread t1(data_producer<lock_free_list<int>>, std::ref(list));
+		std::jthread t2(data_producer<lock_free_list<int>>, std::ref(list));
+
+		// the exact count below needs every push done before the cleaner runs
+		t1.join();
+		t2.join();
+
+		std::jthread t3(data_cleaner<lock_free_list<int>>, std::ref(list));
+		std::jthread t4(data_printer<lock_free_list<int>>, std::ref(list));
+	}
+
+	int count = 0;
+	list.for_each([&count](int const& val) {
+		assert(val % 2 == 1);
+		count++;
+		});
+
+	assert(count == 100);
+	assert(list.find_first_if([](int const& val) { return val == 99; }));
+	assert(!list.find_first_if([](int const& val) { return val == 98; }));
+	list.remove_if([](int const& val) { return val < 50; });
+	assert(!list.find_first_if([](int const& val) { return val == 49; }));
+	std::println("Test passed!");
+
+	run_benchmark<threadsafe_list<int>>("hand-over-hand threadsafe_list");
+	run_benchmark<lock_free_list<int>>("lock_free_list (epochs)");
+	return 0;
+}
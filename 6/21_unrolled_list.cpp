@@ -0,0 +1,335 @@
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <malloc.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <print>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// bytes currently handed out by malloc, including its per-allocation headers
+std::size_t heap_in_use() {
+	return mallinfo2().uordblks;
+}
+
+// Listing 6.13, the hand-over-hand baseline
+template<typename T>
+class threadsafe_list {
+	struct node {
+		std::mutex m;
+		std::shared_ptr<T> data;
+		std::unique_ptr<node> next;
+		node() : next() {}
+		node(T const& value) : data(std::make_shared<T>(value)) {}
+	};
+	node head;
+public:
+	threadsafe_list() {}
+
+	~threadsafe_list() {
+		remove_if([](T const&) {return true; });
+	}
+
+	threadsafe_list(threadsafe_list const& other) = delete;
+
+	threadsafe_list& operator=(threadsafe_list const& other) = delete;
+
+	void push_front(T const& value) {
+		std::unique_ptr<node> new_node(new node(value));
+		std::lock_guard<std::mutex> lk(head.m);
+		new_node->next = std::move(head.next);
+		head.next = std::move(new_node);
+	}
+
+	template<typename Function> requires std::invocable<Function, T&>
+	void for_each(Function f) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get())
+		{
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			f(*next->data);
+			current = next;
+			lk = std::move(next_lk);
+		}
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	std::shared_ptr<T> find_first_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			if (p(*next->data)) {
+				return next->data;
+			}
+			current = next;
+			lk = std::move(next_lk);
+		}
+		return std::shared_ptr<T>();
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			if (p(*next->data)) {
+				std::unique_ptr<node> old_next = std::move(current->next);
+				current->next = std::move(next->next);
+				next_lk.unlock();
+			}
+			else {
+				lk.unlock();
+				current = next;
+				lk = std::move(next_lk);
+			}
+		}
+	}
+};
+
+// Same hand-over-hand locking, but each node stores up to K elements inline under its one
+// mutex, so a scan takes a lock and follows a pointer once per K elements instead of once
+// per element. Within a node the newest element is last, so iterating a node backwards
+// keeps push_front order.
+template<typename T, std::size_t K = 16>
+class unrolled_list {
+	struct node {
+		std::mutex m;
+		std::size_t count = 0;
+		alignas(T) std::byte storage[K * sizeof(T)];
+		std::unique_ptr<node> next;
+
+		T& item(std::size_t i) {
+			return *std::launder(reinterpret_cast<T*>(storage) + i);
+		}
+
+		void push(T const& value) {
+			std::construct_at(reinterpret_cast<T*>(storage) + count, value);
+			++count;
+		}
+
+		// removes matching items in place, keeping the others in order
+		template<typename Predicate>
+		void erase_if(Predicate& p) {
+			std::size_t kept = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				if (p(std::as_const(item(i)))) {
+					continue;
+				}
+				if (kept != i) {
+					item(kept) = std::move(item(i));
+				}
+				++kept;
+			}
+			for (std::size_t i = kept; i < count; ++i) {
+				std::destroy_at(&item(i));
+			}
+			count = kept;
+		}
+
+		node() {}
+
+		~node() {
+			for (std::size_t i = 0; i < count; ++i) {
+				std::destroy_at(&item(i));
+			}
+		}
+	};
+	node head;
+public:
+	unrolled_list() {}
+
+	~unrolled_list() {
+		// unlink iteratively so a long list doesn't recurse through unique_ptr destructors
+		std::unique_ptr<node> current = std::move(head.next);
+		while (current) {
+			current = std::move(current->next);
+		}
+	}
+
+	unrolled_list(unrolled_list const& other) = delete;
+
+	unrolled_list& operator=(unrolled_list const& other) = delete;
+
+	void push_front(T const& value) {
+		std::lock_guard<std::mutex> lk(head.m);
+		if (node* const first = head.next.get()) {
+			std::lock_guard<std::mutex> first_lk(first->m);
+			if (first->count < K) {
+				first->push(value);
+				return;
+			}
+		}
+		std::unique_ptr<node> new_node(new node);
+		new_node->push(value);
+		new_node->next = std::move(head.next);
+		head.next = std::move(new_node);
+	}
+
+	template<typename Function> requires std::invocable<Function, T&>
+	void for_each(Function f) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get())
+		{
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			for (std::size_t i = next->count; i-- > 0; ) {
+				f(next->item(i));
+			}
+			current = next;
+			lk = std::move(next_lk);
+		}
+	}
+
+	// elements live inside the node, so the result is a copy rather than a shared element
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	std::shared_ptr<T> find_first_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			lk.unlock();
+			for (std::size_t i = next->count; i-- > 0; ) {
+				if (p(std::as_const(next->item(i)))) {
+					return std::make_shared<T>(next->item(i));
+				}
+			}
+			current = next;
+			lk = std::move(next_lk);
+		}
+		return std::shared_ptr<T>();
+	}
+
+	template<typename Predicate> requires std::predicate<Predicate, T const&>
+	void remove_if(Predicate p) {
+		node* current = &head;
+		std::unique_lock<std::mutex> lk(head.m);
+		while (node* const next = current->next.get()) {
+			std::unique_lock<std::mutex> next_lk(next->m);
+			next->erase_if(p);
+			if (next->count == 0) {
+				std::unique_ptr<node> old_next = std::move(current->next);
+				current->next = std::move(next->next);
+				next_lk.unlock();
+			}
+			else {
+				lk.unlock();
+				current = next;
+				lk = std::move(next_lk);
+			}
+		}
+	}
+};
+
+void data_producer(unrolled_list<int>& list) {
+	for (int i = 0; i < 100; ++i) {
+		list.push_front(i);
+	}
+}
+
+void data_cleaner(unrolled_list<int>& list) {
+	// remove all even numbers
+	list.remove_if([](int const& val) {
+		return val % 2 == 0;
+		});
+}
+
+void data_printer(unrolled_list<int>& list) {
+	int count = 0;
+	list.for_each([&count](int&) {
+		count++;
+		});
+	std::println("Counted items: {}", count);
+}
+
+template<typename List>
+void run_benchmark(std::string const& name) {
+	const int num_elements = 1000000;
+	const int num_threads = 4;
+	const int scans_per_thread = 5;
+
+	std::size_t const bytes_before = heap_in_use();
+	List list;
+	for (int i = 0; i < num_elements; ++i) {
+		list.push_front(i);
+	}
+	double const bytes_per_element = double(heap_in_use() - bytes_before) / num_elements;
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&list]() {
+			for (int i = 0; i < scans_per_thread; ++i) {
+				long long sum = 0;
+				list.for_each([&sum](int& val) { sum += val; });
+				assert(sum == (long long)num_elements * (num_elements - 1) / 2);
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> duration = end - start;
+	double const ns_per_element = duration.count() * 1e6 / (double(num_threads) * scans_per_thread * num_elements);
+	std::println("{:<30} {:>6.1f} bytes/element | {:>7.1f} ms, {:.2f} ns/element",
+		name, bytes_per_element, duration.count(), ns_per_element);
+}
+
+int main() {
+	unrolled_list<int> list;
+
+	{
+		std::jthread t1(data_producer, std::ref(list));
+		std::jthread t2(data_producer, std::ref(list));
+
+		// the exact count below needs every push done before the cleaner runs
+		t1.join();
+		t2.join();
+
+		std::jthread t3(data_cleaner, std::ref(list));
+		std::jthread t4(data_printer, std::ref(list));
+	}
+
+	int count = 0;
+	list.for_each([&count](int& val) {
+		assert(val % 2 == 1);
+		count++;
+		});
+
+	assert(count == 100);
+	assert(list.find_first_if([](int const& val) { return val == 99; }));
+	assert(!list.find_first_if([](int const& val) { return val == 98; }));
+
+	unrolled_list<int, 4> ordered;
+	for (int i = 0; i < 10; ++i) {
+		ordered.push_front(i);
+	}
+	ordered.remove_if([](int const& val) { return val % 3 == 0; });
+	int expected = 9;
+	ordered.for_each([&expected](int& val) {
+		while (expected % 3 == 0) {
+			--expected;
+		}
+		assert(val == expected);
+		--expected;
+		});
+	std::println("Test passed!");
+
+	run_benchmark<threadsafe_list<int>>("hand-over-hand threadsafe_list");
+	run_benchmark<unrolled_list<int, 4>>("unrolled_list, K = 4");
+	run_benchmark<unrolled_list<int, 16>>("unrolled_list, K = 16");
+	run_benchmark<unrolled_list<int, 64>>("unrolled_list, K = 64");
+	return 0;
+}
@@ -0,0 +1,378 @@
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "epoch_reclamation.h"
+
+// Lazy skiplist (Herlihy, Lev, Luchangco, Shavit): lookups and scans take no locks and skip
+// nodes that are marked or not yet fully linked. Insert and erase lock only the predecessors
+// at the levels they touch, validate them, then splice. Locks are always taken from higher
+// keys to lower ones, so writers cannot deadlock. Values are immutable once published;
+// an assignment swaps in a new one and retires the old one through the epoch.
+template<typename Key, typename Value>
+class skiplist_map {
+	static int const max_level = 20;
+
+	struct node {
+		Key key;
+		std::atomic<Value const*> value;
+		int const top_level;
+		std::mutex m;
+		std::atomic<bool> marked{ false };
+		std::atomic<bool> fully_linked{ false };
+		std::atomic<node*> next[max_level];
+
+		node(Key const& key_, Value const* value_, int top_level_) : key(key_), value(value_), top_level(top_level_) {
+			for (auto& link : next) {
+				link.store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		~node() {
+			delete value.load();
+		}
+	};
+
+	node head;
+
+	static int random_level() {
+		thread_local std::mt19937 gen(std::random_device{}());
+		// each further level with probability 1/2
+		return std::countr_zero(std::uint32_t(gen()) | (std::uint32_t(1) << (max_level - 1)));
+	}
+
+	// fills preds/succs around key at every level; returns the highest level where key was found, or -1
+	int find(Key const& key, node** preds, node** succs) {
+		int found_level = -1;
+		node* pred = &head;
+		for (int level = max_level - 1; level >= 0; --level) {
+			node* current = pred->next[level].load();
+			while (current && current->key < key) {
+				pred = current;
+				current = pred->next[level].load();
+			}
+			if (found_level == -1 && current && !(key < current->key)) {
+				found_level = level;
+			}
+			preds[level] = pred;
+			succs[level] = current;
+		}
+		return found_level;
+	}
+
+	// first node with key >= key, live or not
+	node* lower_bound_node(Key const& key) {
+		node* pred = &head;
+		node* current = nullptr;
+		for (int level = max_level - 1; level >= 0; --level) {
+			current = pred->next[level].load();
+			while (current && current->key < key) {
+				pred = current;
+				current = pred->next[level].load();
+			}
+		}
+		return current;
+	}
+
+	static bool is_live(node* n) {
+		return n->fully_linked.load() && !n->marked.load();
+	}
+
+public:
+	typedef Key key_type;
+	typedef Value mapped_type;
+
+	skiplist_map() : head(Key(), nullptr, max_level - 1) {}
+
+	~skiplist_map() {
+		node* current = head.next[0].load();
+		while (current) {
+			node* const next = current->next[0].load();
+			delete current;
+			current = next;
+		}
+	}
+
+	skiplist_map(skiplist_map const& other) = delete;
+	skiplist_map& operator=(skiplist_map const& other) = delete;
+
+	std::optional<Value> find(Key const& key) {
+		epoch_guard guard;
+		node* const found = lower_bound_node(key);
+		if (found && !(key < found->key) && is_live(found)) {
+			return *found->value.load();
+		}
+		return std::nullopt;
+	}
+
+	std::optional<std::pair<Key, Value>> lower_bound(Key const& key) {
+		epoch_guard guard;
+		for (node* current = lower_bound_node(key); current; current = current->next[0].load()) {
+			if (is_live(current)) {
+				return std::pair<Key, Value>(current->key, *current->value.load());
+			}
+		}
+		return std::nullopt;
+	}
+
+	// visits the live entries in [lo, hi) in key order; concurrent updates may or may not be seen
+	template<typename Function> requires std::invocable<Function, Key const&, Value const&>
+	void range(Key const& lo, Key const& hi, Function fn) {
+		epoch_guard guard;
+		for (node* current = lower_bound_node(lo); current && current->key < hi; current = current->next[0].load()) {
+			if (is_live(current)) {
+				fn(current->key, *current->value.load());
+			}
+		}
+	}
+
+	void insert_or_assign(Key const& key, Value const& value) {
+		epoch_guard guard;
+		int const top_level = random_level();
+		node* preds[max_level];
+		node* succs[max_level];
+		while (true) {
+			int const found_level = find(key, preds, succs);
+			if (found_level != -1) {
+				node* const found = succs[found_level];
+				if (!found->marked.load()) {
+					while (!found->fully_linked.load()) {
+						std::this_thread::yield();
+					}
+					guard.retire(const_cast<Value*>(found->value.exchange(new Value(value))));
+					return;
+				}
+				// being erased; wait for it to be unlinked and try again
+				continue;
+			}
+
+			std::unique_lock<std::mutex> locks[max_level];
+			node* previous_pred = nullptr;
+			bool valid = true;
+			for (int level = 0; valid && level <= top_level; ++level) {
+				node* const pred = preds[level];
+				node* const succ = succs[level];
+				if (pred != previous_pred) {
+					locks[level] = std::unique_lock<std::mutex>(pred->m);
+					previous_pred = pred;
+				}
+				valid = !pred->marked.load() && (!succ || !succ->marked.load()) && pred->next[level].load() == succ;
+			}
+			if (!valid) {
+				continue;
+			}
+
+			node* const new_node = new node(key, new Value(value), top_level);
+			for (int level = 0; level <= top_level; ++level) {
+				new_node->next[level].store(succs[level]);
+			}
+			for (int level = 0; level <= top_level; ++level) {
+				preds[level]->next[level].store(new_node);
+			}
+			new_node->fully_linked.store(true);
+			return;
+		}
+	}
+
+	bool erase(Key const& key) {
+		epoch_guard guard;
+		node* preds[max_level];
+		node* succs[max_level];
+		node* victim = nullptr;
+		std::unique_lock<std::mutex> victim_lock;
+		while (true) {
+			int const found_level = find(key, preds, succs);
+			if (!victim) {
+				if (found_level == -1) {
+					return false;
+				}
+				node* const candidate = succs[found_level];
+				// only erase a node found at its own top level, i.e. fully linked and seen in full
+				if (!candidate->fully_linked.load() || candidate->top_level != found_level || candidate->marked.load()) {
+					return false;
+				}
+				victim_lock = std::unique_lock<std::mutex>(candidate->m);
+				if (candidate->marked.load()) {
+					return false;
+				}
+				candidate->marked.store(true);
+				victim = candidate;
+			}
+
+			std::unique_lock<std::mutex> locks[max_level];
+			node* previous_pred = nullptr;
+			bool valid = true;
+			for (int level = 0; valid && level <= victim->top_level; ++level) {
+				node* const pred = preds[level];
+				if (pred != previous_pred) {
+					locks[level] = std::unique_lock<std::mutex>(pred->m);
+					previous_pred = pred;
+				}
+				valid = !pred->marked.load() && pred->next[level].load() == victim;
+			}
+			if (!valid) {
+				continue;
+			}
+
+			for (int level = victim->top_level; level >= 0; --level) {
+				preds[level]->next[level].store(victim->next[level].load());
+			}
+			victim_lock.unlock();
+			guard.retire(victim);
+			return true;
+		}
+	}
+};
+
+// the dns_cache layout from Listing 3.13: one std::map behind one shared_mutex
+template<typename Key, typename Value>
+class locked_map {
+	std::map<Key, Value> entries;
+	mutable std::shared_mutex entry_mutex;
+public:
+	std::optional<Value> find(Key const& key) const {
+		std::shared_lock<std::shared_mutex> lk(entry_mutex);
+		auto const it = entries.find(key);
+		return (it == entries.end()) ? std::nullopt : std::optional<Value>(it->second);
+	}
+
+	std::optional<std::pair<Key, Value>> lower_bound(Key const& key) const {
+		std::shared_lock<std::shared_mutex> lk(entry_mutex);
+		auto const it = entries.lower_bound(key);
+		return (it == entries.end()) ? std::nullopt : std::optional<std::pair<Key, Value>>(*it);
+	}
+
+	template<typename Function> requires std::invocable<Function, Key const&, Value const&>
+	void range(Key const& lo, Key const& hi, Function fn) const {
+		std::shared_lock<std::shared_mutex> lk(entry_mutex);
+		for (auto it = entries.lower_bound(lo); it != entries.end() && it->first < hi; ++it) {
+			fn(it->first, it->second);
+		}
+	}
+
+	void insert_or_assign(Key const& key, Value const& value) {
+		std::lock_guard<std::shared_mutex> lk(entry_mutex);
+		entries.insert_or_assign(key, value);
+	}
+
+	bool erase(Key const& key) {
+		std::lock_guard<std::shared_mutex> lk(entry_mutex);
+		return entries.erase(key) != 0;
+	}
+};
+
+class dns_entry {
+public:
+	std::string address;
+};
+
+// point workload: 90% find, 10% insert_or_assign; range workload: 100-key scans with 5% updates
+template<typename Map>
+void run_benchmark(std::string const& name, bool ranges) {
+	const int num_keys = 100000;
+	const int num_threads = 4;
+	const int ops_per_thread = ranges ? 20000 : 500000;
+	const int range_width = 100;
+
+	Map map;
+	for (int i = 0; i < num_keys; i += 2) {
+		map.insert_or_assign(i, i);
+	}
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&map, t, ranges, ops_per_thread]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+			for (int i = 0; i < ops_per_thread; ++i) {
+				int const key = key_dist(gen) & ~1;
+				if (i % (ranges ? 20 : 10) == 0) {
+					map.insert_or_assign(key, key);
+				}
+				else if (ranges) {
+					long sum = 0;
+					map.range(key, key + range_width, [&sum](int const& k, int const& v) {
+						assert(k == v);
+						sum += v;
+						});
+					(void)sum;
+				}
+				else {
+					std::optional<int> const value = map.find(key);
+					assert(value && *value == key);
+					(void)value;
+				}
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("{:<32} {:<6} {:.1f} ms", name, ranges ? "range" : "point", duration.count());
+}
+
+int main() {
+	skiplist_map<std::string, dns_entry> cache;
+
+	std::thread t1([&]() {
+		for (int i = 0; i < 100; ++i)
+			cache.insert_or_assign("host" + std::to_string(i) + ".example.com", dns_entry{ "10.0.0." + std::to_string(i) });
+		});
+
+	std::thread t2([&]() {
+		for (int i = 100; i < 200; ++i)
+			cache.insert_or_assign("host" + std::to_string(i) + ".example.com", dns_entry{ "10.0.1." + std::to_string(i) });
+		});
+
+	t1.join();
+	t2.join();
+
+	// erase runs against the finished inserts, so exactly every third host is gone
+	std::thread t3([&]() {
+		for (int i = 0; i < 200; i += 3)
+			cache.erase("host" + std::to_string(i) + ".example.com");
+		});
+	t3.join();
+
+	assert(cache.find("host1.example.com")->address == "10.0.0.1");
+	cache.insert_or_assign("host1.example.com", dns_entry{ "10.9.9.9" });
+	assert(cache.find("host1.example.com")->address == "10.9.9.9");
+	assert(cache.erase("host1.example.com"));
+	assert(!cache.erase("host1.example.com"));
+	assert(!cache.find("host1.example.com"));
+	assert(cache.lower_bound("host1.example.com")->first == "host10.example.com");
+	assert(!cache.lower_bound("zzz"));
+
+	std::string previous;
+	int count = 0;
+	cache.range("host1", "host2", [&](std::string const& domain, dns_entry const&) {
+		assert(previous < domain);
+		previous = domain;
+		++count;
+		});
+	// host10..host19 and host100..host199, less every third one erased by t3
+	assert(count == 74);
+	std::println("Test passed!");
+
+	for (bool ranges : { false, true }) {
+		run_benchmark<locked_map<int, int>>("std::map + shared_mutex", ranges);
+		run_benchmark<skiplist_map<int, int>>("skiplist_map", ranges);
+	}
+	return 0;
+}
@@ -0,0 +1,711 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "epoch_reclamation.h"
+
+// Adaptive radix tree (Leis et al.) over string keys, with optimistic lock coupling.
+// Every inner node carries a version word: bit 0 marks it obsolete, bit 1 locks it, the rest
+// counts modifications. Readers never write shared memory: they read a node's version, read
+// its fields, and check the version again before trusting what they saw, restarting from the
+// root if it moved. Writers upgrade the version of the one or two nodes they change.
+// Keys are terminated by an implicit '\0' byte, so they must not contain one themselves.
+// Paths are compressed with up to 8 stored prefix bytes; longer prefixes are skipped
+// optimistically and the full key is checked at the leaf. Nodes replaced by bigger ones are
+// retired through the epoch. There is no erase, so leaves live as long as the tree.
+template<typename Value>
+class adaptive_radix_tree {
+	enum class node_type : std::uint8_t { n4, n16, n48, n256 };
+	static constexpr unsigned max_stored_prefix = 8;
+
+	struct leaf {
+		std::string const key;
+		std::atomic<Value const*> value;
+		leaf(std::string const& key_, Value const* value_) : key(key_), value(value_) {}
+		~leaf() {
+			delete value.load();
+		}
+	};
+
+	// children are node pointers, or leaf pointers tagged with the low bit
+	struct node {
+		std::atomic<std::uint64_t> version{ 0 };
+		node_type const type;
+		std::atomic<std::uint16_t> count{ 0 };
+		std::atomic<std::uint32_t> prefix_length{ 0 };
+		std::atomic<std::uint8_t> prefix[max_stored_prefix] = {};
+		explicit node(node_type type_) : type(type_) {}
+	};
+
+	// Node4 and Node16: keys kept sorted so scans come out in order
+	template<unsigned Capacity, node_type Type>
+	struct sorted_node : node {
+		std::atomic<std::uint8_t> keys[Capacity] = {};
+		std::atomic<node*> children[Capacity] = {};
+
+		sorted_node() : node(Type) {}
+
+		node* find(std::uint8_t byte) const {
+			unsigned const count = std::min<unsigned>(this->count.load(std::memory_order_relaxed), Capacity);
+			for (unsigned i = 0; i < count; ++i) {
+				if (keys[i].load(std::memory_order_relaxed) == byte) {
+					return children[i].load(std::memory_order_relaxed);
+				}
+			}
+			return nullptr;
+		}
+
+		bool full() const {
+			return this->count.load(std::memory_order_relaxed) == Capacity;
+		}
+
+		void insert(std::uint8_t byte, node* child) {
+			unsigned position = this->count.load(std::memory_order_relaxed);
+			while (position > 0 && keys[position - 1].load(std::memory_order_relaxed) > byte) {
+				keys[position].store(keys[position - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				children[position].store(children[position - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				--position;
+			}
+			keys[position].store(byte, std::memory_order_relaxed);
+			children[position].store(child, std::memory_order_relaxed);
+			this->count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void change(std::uint8_t byte, node* child) {
+			for (unsigned i = 0; i < this->count.load(std::memory_order_relaxed); ++i) {
+				if (keys[i].load(std::memory_order_relaxed) == byte) {
+					children[i].store(child, std::memory_order_relaxed);
+					return;
+				}
+			}
+		}
+
+		template<typename Function>
+		void for_each_child(Function f) const {
+			unsigned const count = std::min<unsigned>(this->count.load(std::memory_order_relaxed), Capacity);
+			for (unsigned i = 0; i < count; ++i) {
+				f(keys[i].load(std::memory_order_relaxed), children[i].load(std::memory_order_relaxed));
+			}
+		}
+	};
+
+	typedef sorted_node<4, node_type::n4> node4;
+	typedef sorted_node<16, node_type::n16> node16;
+
+	// Node48: a 256-entry byte index into 48 child slots
+	struct node48 : node {
+		static constexpr std::uint8_t empty = 0xff;
+		std::atomic<std::uint8_t> child_index[256];
+		std::atomic<node*> children[48] = {};
+
+		node48() : node(node_type::n48) {
+			for (auto& index : child_index) {
+				index.store(empty, std::memory_order_relaxed);
+			}
+		}
+
+		node* find(std::uint8_t byte) const {
+			std::uint8_t const index = child_index[byte].load(std::memory_order_relaxed);
+			return (index == empty) ? nullptr : children[index % 48].load(std::memory_order_relaxed);
+		}
+
+		bool full() const {
+			return this->count.load(std::memory_order_relaxed) == 48;
+		}
+
+		void insert(std::uint8_t byte, node* child) {
+			// nothing is ever removed, so the next free slot is always count
+			std::uint16_t const slot = this->count.load(std::memory_order_relaxed);
+			children[slot].store(child, std::memory_order_relaxed);
+			child_index[byte].store(std::uint8_t(slot), std::memory_order_relaxed);
+			this->count.store(slot + 1, std::memory_order_relaxed);
+		}
+
+		void change(std::uint8_t byte, node* child) {
+			children[child_index[byte].load(std::memory_order_relaxed)].store(child, std::memory_order_relaxed);
+		}
+
+		template<typename Function>
+		void for_each_child(Function f) const {
+			for (unsigned byte = 0; byte < 256; ++byte) {
+				std::uint8_t const index = child_index[byte].load(std::memory_order_relaxed);
+				if (index != empty) {
+					f(std::uint8_t(byte), children[index % 48].load(std::memory_order_relaxed));
+				}
+			}
+		}
+	};
+
+	struct node256 : node {
+		std::atomic<node*> children[256] = {};
+
+		node256() : node(node_type::n256) {}
+
+		node* find(std::uint8_t byte) const {
+			return children[byte].load(std::memory_order_relaxed);
+		}
+
+		bool full() const {
+			return false;
+		}
+
+		void insert(std::uint8_t byte, node* child) {
+			children[byte].store(child, std::memory_order_relaxed);
+			this->count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void change(std::uint8_t byte, node* child) {
+			children[byte].store(child, std::memory_order_relaxed);
+		}
+
+		template<typename Function>
+		void for_each_child(Function f) const {
+			for (unsigned byte = 0; byte < 256; ++byte) {
+				if (node* const child = children[byte].load(std::memory_order_relaxed)) {
+					f(std::uint8_t(byte), child);
+				}
+			}
+		}
+	};
+
+	template<typename Function>
+	static decltype(auto) dispatch(node* n, Function f) {
+		switch (n->type) {
+		case node_type::n4: return f(static_cast<node4*>(n));
+		case node_type::n16: return f(static_cast<node16*>(n));
+		case node_type::n48: return f(static_cast<node48*>(n));
+		default: return f(static_cast<node256*>(n));
+		}
+	}
+
+	static bool is_leaf(node* p) {
+		return reinterpret_cast<std::uintptr_t>(p) & 1;
+	}
+
+	static leaf* as_leaf(node* p) {
+		return reinterpret_cast<leaf*>(reinterpret_cast<std::uintptr_t>(p) & ~std::uintptr_t(1));
+	}
+
+	static node* tagged(leaf* l) {
+		return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(l) | 1);
+	}
+
+	static std::uint8_t key_byte(std::string_view key, std::size_t position) {
+		return (position < key.size()) ? std::uint8_t(key[position]) : 0;
+	}
+
+	static bool read_lock(node* n, std::uint64_t& version) {
+		version = n->version.load(std::memory_order_acquire);
+		return !(version & 3);
+	}
+
+	static bool validate(node* n, std::uint64_t version) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return n->version.load(std::memory_order_relaxed) == version;
+	}
+
+	static bool upgrade(node* n, std::uint64_t version) {
+		if (!n->version.compare_exchange_strong(version, version + 2, std::memory_order_acquire)) {
+			return false;
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		return true;
+	}
+
+	static void write_unlock(node* n) {
+		n->version.fetch_add(2, std::memory_order_release);
+	}
+
+	static void write_unlock_obsolete(node* n) {
+		n->version.fetch_add(3, std::memory_order_release);
+	}
+
+	static node* find_child(node* n, std::uint8_t byte) {
+		return dispatch(n, [byte](auto* typed) { return typed->find(byte); });
+	}
+
+	static void set_prefix(node* n, std::string_view bytes) {
+		n->prefix_length.store(std::uint32_t(bytes.size()), std::memory_order_relaxed);
+		for (std::size_t i = 0; i < std::min<std::size_t>(bytes.size(), max_stored_prefix); ++i) {
+			n->prefix[i].store(std::uint8_t(bytes[i]), std::memory_order_relaxed);
+		}
+	}
+
+	// any leaf below n; all of them share n's full prefix
+	static leaf* any_leaf(node* n) {
+		while (n && !is_leaf(n)) {
+			node* first = nullptr;
+			dispatch(n, [&first](auto* typed) {
+				typed->for_each_child([&first](std::uint8_t, node* child) {
+					if (!first) {
+						first = child;
+					}
+					});
+				});
+			n = first;
+		}
+		return n ? as_leaf(n) : nullptr;
+	}
+
+	// the whole compressed path of n, which starts at key position level
+	static bool full_prefix(node* n, std::uint64_t version, std::size_t level, std::string& prefix) {
+		std::uint32_t const length = n->prefix_length.load(std::memory_order_relaxed);
+		if (!validate(n, version)) {
+			return false;
+		}
+		prefix.resize(length);
+		if (length <= max_stored_prefix) {
+			for (std::uint32_t i = 0; i < length; ++i) {
+				prefix[i] = char(n->prefix[i].load(std::memory_order_relaxed));
+			}
+		}
+		else {
+			leaf* const l = any_leaf(n);
+			if (!l) {
+				return false;
+			}
+			for (std::uint32_t i = 0; i < length; ++i) {
+				prefix[i] = char(key_byte(l->key, level + i));
+			}
+		}
+		return validate(n, version);
+	}
+
+	static node* grow(node* n) {
+		node* bigger = nullptr;
+		switch (n->type) {
+		case node_type::n4: bigger = new node16; break;
+		case node_type::n16: bigger = new node48; break;
+		default: bigger = new node256; break;
+		}
+		bigger->prefix_length.store(n->prefix_length.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		for (unsigned i = 0; i < max_stored_prefix; ++i) {
+			bigger->prefix[i].store(n->prefix[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		dispatch(n, [bigger](auto* from) {
+			from->for_each_child([bigger](std::uint8_t byte, node* child) {
+				dispatch(bigger, [byte, child](auto* to) { to->insert(byte, child); });
+				});
+			});
+		return bigger;
+	}
+
+	static void insert_child(node* n, std::uint8_t byte, node* child) {
+		dispatch(n, [byte, child](auto* typed) { typed->insert(byte, child); });
+	}
+
+	static void change_child(node* n, std::uint8_t byte, node* child) {
+		dispatch(n, [byte, child](auto* typed) { typed->change(byte, child); });
+	}
+
+	static void retire(epoch_guard& guard, node* n) {
+		dispatch(n, [&guard](auto* typed) { guard.retire(typed); });
+	}
+
+	static void destroy(node* n) {
+		if (is_leaf(n)) {
+			delete as_leaf(n);
+			return;
+		}
+		dispatch(n, [](auto* typed) {
+			typed->for_each_child([](std::uint8_t, node* child) { destroy(child); });
+			delete typed;
+			});
+	}
+
+	node256* const root;
+
+	bool try_find(std::string_view key, Value const*& found) {
+		node* n = root;
+		std::uint64_t version;
+		if (!read_lock(n, version)) {
+			return false;
+		}
+		std::size_t level = 0;
+		while (true) {
+			std::uint32_t const prefix_length = n->prefix_length.load(std::memory_order_relaxed);
+			for (std::uint32_t i = 0; i < std::min<std::uint32_t>(prefix_length, max_stored_prefix); ++i) {
+				if (n->prefix[i].load(std::memory_order_relaxed) != key_byte(key, level + i)) {
+					found = nullptr;
+					return validate(n, version);
+				}
+			}
+			level += prefix_length;
+			node* const child = find_child(n, key_byte(key, level));
+			if (!validate(n, version)) {
+				return false;
+			}
+			if (!child) {
+				found = nullptr;
+				return true;
+			}
+			if (is_leaf(child)) {
+				leaf* const l = as_leaf(child);
+				found = (l->key == key) ? l->value.load() : nullptr;
+				return true;
+			}
+			++level;
+			std::uint64_t child_version;
+			if (!read_lock(child, child_version) || !validate(n, version)) {
+				return false;
+			}
+			n = child;
+			version = child_version;
+		}
+	}
+
+	bool try_insert(std::string const& key, Value const& value, epoch_guard& guard) {
+		node* parent = nullptr;
+		std::uint64_t parent_version = 0;
+		std::uint8_t parent_byte = 0;
+		node* n = root;
+		std::uint64_t version;
+		if (!read_lock(n, version)) {
+			return false;
+		}
+		std::size_t level = 0;
+		std::string prefix;
+		while (true) {
+			if (!full_prefix(n, version, level, prefix)) {
+				return false;
+			}
+			std::size_t matched = 0;
+			while (matched < prefix.size() && key_byte(key, level + matched) == std::uint8_t(prefix[matched])) {
+				++matched;
+			}
+			if (matched < prefix.size()) {
+				// the key leaves the compressed path: a new Node4 takes over the matched part
+				if (!upgrade(parent, parent_version)) {
+					return false;
+				}
+				if (!upgrade(n, version)) {
+					write_unlock(parent);
+					return false;
+				}
+				node4* const split = new node4;
+				set_prefix(split, std::string_view(prefix).substr(0, matched));
+				split->insert(std::uint8_t(prefix[matched]), n);
+				split->insert(key_byte(key, level + matched), tagged(new leaf(key, new Value(value))));
+				set_prefix(n, std::string_view(prefix).substr(matched + 1));
+				change_child(parent, parent_byte, split);
+				write_unlock(n);
+				write_unlock(parent);
+				return true;
+			}
+			level += prefix.size();
+
+			std::uint8_t const byte = key_byte(key, level);
+			node* const child = find_child(n, byte);
+			bool const full = dispatch(n, [](auto* typed) { return typed->full(); });
+			if (!validate(n, version)) {
+				return false;
+			}
+			if (!child) {
+				if (full) {
+					if (!upgrade(parent, parent_version)) {
+						return false;
+					}
+					if (!upgrade(n, version)) {
+						write_unlock(parent);
+						return false;
+					}
+					node* const bigger = grow(n);
+					insert_child(bigger, byte, tagged(new leaf(key, new Value(value))));
+					change_child(parent, parent_byte, bigger);
+					write_unlock_obsolete(n);
+					retire(guard, n);
+					write_unlock(parent);
+					return true;
+				}
+				if (!upgrade(n, version)) {
+					return false;
+				}
+				if (parent && !validate(parent, parent_version)) {
+					write_unlock(n);
+					return false;
+				}
+				insert_child(n, byte, tagged(new leaf(key, new Value(value))));
+				write_unlock(n);
+				return true;
+			}
+			if (parent && !validate(parent, parent_version)) {
+				return false;
+			}
+			if (is_leaf(child)) {
+				leaf* const existing = as_leaf(child);
+				if (existing->key == key) {
+					guard.retire(const_cast<Value*>(existing->value.exchange(new Value(value))));
+					return true;
+				}
+				if (!upgrade(n, version)) {
+					return false;
+				}
+				// push both leaves one level down under their common part
+				std::size_t common = 0;
+				while (key_byte(key, level + 1 + common) == key_byte(existing->key, level + 1 + common)) {
+					++common;
+				}
+				node4* const split = new node4;
+				set_prefix(split, std::string_view(key).substr(level + 1, common));
+				split->insert(key_byte(existing->key, level + 1 + common), child);
+				split->insert(key_byte(key, level + 1 + common), tagged(new leaf(key, new Value(value))));
+				change_child(n, byte, split);
+				write_unlock(n);
+				return true;
+			}
+			++level;
+			parent = n;
+			parent_version = version;
+			parent_byte = byte;
+			n = child;
+			if (!read_lock(n, version)) {
+				return false;
+			}
+		}
+	}
+
+	// reads a consistent view of one node's children, waiting out writers; an obsolete node
+	// still holds the children it had when it was replaced
+	static void snapshot(node* n, std::string& stored_prefix, std::uint32_t& prefix_length,
+		std::vector<std::pair<std::uint8_t, node*>>& children) {
+		while (true) {
+			std::uint64_t const version = n->version.load(std::memory_order_acquire);
+			if (version & 2) {
+				std::this_thread::yield();
+				continue;
+			}
+			prefix_length = n->prefix_length.load(std::memory_order_relaxed);
+			stored_prefix.clear();
+			for (std::uint32_t i = 0; i < std::min<std::uint32_t>(prefix_length, max_stored_prefix); ++i) {
+				stored_prefix.push_back(char(n->prefix[i].load(std::memory_order_relaxed)));
+			}
+			children.clear();
+			dispatch(n, [&children](auto* typed) {
+				typed->for_each_child([&children](std::uint8_t byte, node* child) { children.emplace_back(byte, child); });
+				});
+			if (validate(n, version)) {
+				return;
+			}
+		}
+	}
+
+	template<typename Function>
+	static void scan(node* n, std::size_t level, std::string_view prefix, Function& fn) {
+		if (is_leaf(n)) {
+			leaf* const l = as_leaf(n);
+			if (l->key.starts_with(prefix)) {
+				fn(l->key, *l->value.load());
+			}
+			return;
+		}
+		std::string stored_prefix;
+		std::uint32_t prefix_length;
+		std::vector<std::pair<std::uint8_t, node*>> children;
+		snapshot(n, stored_prefix, prefix_length, children);
+		for (std::size_t i = 0; i < stored_prefix.size() && level + i < prefix.size(); ++i) {
+			if (stored_prefix[i] != prefix[level + i]) {
+				return;
+			}
+		}
+		level += prefix_length;
+		for (auto const& [byte, child] : children) {
+			if (level < prefix.size() && byte != std::uint8_t(prefix[level])) {
+				continue;
+			}
+			scan(child, level + 1, prefix, fn);
+		}
+	}
+
+public:
+	adaptive_radix_tree() : root(new node256) {}
+
+	~adaptive_radix_tree() {
+		destroy(root);
+	}
+
+	adaptive_radix_tree(adaptive_radix_tree const& other) = delete;
+	adaptive_radix_tree& operator=(adaptive_radix_tree const& other) = delete;
+
+	std::optional<Value> find(std::string_view key) {
+		epoch_guard guard;
+		Value const* found = nullptr;
+		while (!try_find(key, found)) {
+			std::this_thread::yield();
+		}
+		return found ? std::optional<Value>(*found) : std::nullopt;
+	}
+
+	void insert_or_assign(std::string const& key, Value const& value) {
+		assert(key.find('\0') == std::string::npos);
+		epoch_guard guard;
+		while (!try_insert(key, value, guard)) {
+			std::this_thread::yield();
+		}
+	}
+
+	// visits every entry whose key starts with prefix, in key order; entries inserted during
+	// the scan may or may not be seen
+	template<typename Function> requires std::invocable<Function, std::string const&, Value const&>
+	void scan_prefix(std::string_view prefix, Function fn) {
+		epoch_guard guard;
+		scan(root, 0, prefix, fn);
+	}
+};
+
+class dns_entry {
+public:
+	std::string address;
+};
+
+// Listing 3.13
+class map_dns_cache {
+	std::map<std::string, dns_entry> entries;
+	mutable std::shared_mutex entry_mutex;
+public:
+	std::optional<dns_entry> find_entry(std::string const& domain) const {
+		std::shared_lock<std::shared_mutex> lk(entry_mutex);
+		auto const it = entries.find(domain);
+		return (it == entries.end()) ? std::nullopt : std::optional<dns_entry>(it->second);
+	}
+
+	void update_or_add_entry(std::string const& domain, dns_entry const& dns_details) {
+		std::lock_guard<std::shared_mutex> lk(entry_mutex);
+		entries[domain] = dns_details;
+	}
+};
+
+// the same interface backed by the radix tree, plus prefix queries
+class dns_cache {
+	adaptive_radix_tree<dns_entry> entries;
+public:
+	std::optional<dns_entry> find_entry(std::string const& domain) {
+		return entries.find(domain);
+	}
+
+	void update_or_add_entry(std::string const& domain, dns_entry const& dns_details) {
+		entries.insert_or_assign(domain, dns_details);
+	}
+
+	template<typename Function> requires std::invocable<Function, std::string const&, dns_entry const&>
+	void for_each_entry_with_prefix(std::string const& prefix, Function fn) {
+		entries.scan_prefix(prefix, fn);
+	}
+};
+
+std::string domain_name(std::size_t i) {
+	static char const* const zones[] = { ".example.com", ".example.org", ".cdn.example.net", ".mail.example.com" };
+	return "host" + std::to_string(i) + zones[i % 4];
+}
+
+template<typename Cache>
+void run_benchmark(std::string const& name, std::size_t num_domains) {
+	const int num_threads = 4;
+	const int lookups_per_thread = 1000000;
+
+	auto build_start = std::chrono::high_resolution_clock::now();
+	Cache cache;
+	for (std::size_t i = 0; i < num_domains; ++i) {
+		cache.update_or_add_entry(domain_name(i), dns_entry{ "10.0.0.1" });
+	}
+	auto build_end = std::chrono::high_resolution_clock::now();
+
+	// domain strings are built up front so only the lookups are timed
+	std::vector<std::vector<std::string>> queries(num_threads);
+	for (int t = 0; t < num_threads; ++t) {
+		std::mt19937_64 gen(t);
+		std::uniform_int_distribution<std::size_t> dist(0, num_domains - 1);
+		for (int i = 0; i < lookups_per_thread; ++i) {
+			queries[t].push_back(domain_name(dist(gen)));
+		}
+	}
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&cache, &queries, t]() {
+			for (std::string const& domain : queries[t]) {
+				bool const found = cache.find_entry(domain).has_value();
+				assert(found);
+				(void)found;
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> build = build_end - build_start;
+	std::chrono::duration<double> duration = end - start;
+	std::println("{:<28} {} domains: built in {:.1f} s, {:.2f} M lookups/s",
+		name, num_domains, build.count(), num_threads * lookups_per_thread / duration.count() / 1e6);
+}
+
+int main(int argc, char* argv[]) {
+	dns_cache cache;
+	std::map<std::string, dns_entry> reference;
+	{
+		std::vector<std::jthread> writers;
+		for (int t = 0; t < 4; ++t) {
+			writers.emplace_back([&cache, t]() {
+				for (std::size_t i = t; i < 20000; i += 4) {
+					cache.update_or_add_entry(domain_name(i), dns_entry{ "10.0.0." + std::to_string(t) });
+				}
+				});
+		}
+		std::jthread reader([&cache]() {
+			for (std::size_t i = 0; i < 20000; ++i) {
+				std::optional<dns_entry> const entry = cache.find_entry(domain_name(i));
+				assert(!entry || entry->address == "10.0.0." + std::to_string(i % 4));
+			}
+			});
+	}
+	for (std::size_t i = 0; i < 20000; ++i) {
+		reference[domain_name(i)] = dns_entry{ "10.0.0." + std::to_string(i % 4) };
+	}
+
+	for (auto const& [domain, entry] : reference) {
+		assert(cache.find_entry(domain)->address == entry.address);
+	}
+	assert(!cache.find_entry("host20000.example.com"));
+	assert(!cache.find_entry("host1"));
+	assert(!cache.find_entry(""));
+	cache.update_or_add_entry("host1", dns_entry{ "10.1.1.1" });
+	assert(cache.find_entry("host1")->address == "10.1.1.1");
+	assert(cache.find_entry("host1.example.org")->address == "10.0.0.1");
+	cache.update_or_add_entry("host1", dns_entry{ "10.2.2.2" });
+	assert(cache.find_entry("host1")->address == "10.2.2.2");
+	reference["host1"] = dns_entry{ "10.2.2.2" };
+
+	for (std::string const prefix : { "host1", "host123", "host19999.", "host7.", "nope", "" }) {
+		std::vector<std::string> expected;
+		for (auto it = reference.lower_bound(prefix); it != reference.end() && it->first.starts_with(prefix); ++it) {
+			expected.push_back(it->first);
+		}
+		std::vector<std::string> scanned;
+		cache.for_each_entry_with_prefix(prefix, [&scanned](std::string const& domain, dns_entry const&) {
+			scanned.push_back(domain);
+			});
+		assert(scanned == expected);
+	}
+	std::println("Test passed!");
+
+	std::size_t const num_domains = (argc > 1) ? std::stoul(argv[1]) : 10000000;
+	run_benchmark<map_dns_cache>("std::map + shared_mutex", num_domains);
+	run_benchmark<dns_cache>("adaptive radix tree", num_domains);
+	return 0;
+}
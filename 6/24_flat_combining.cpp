@@ -0,0 +1,299 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <print>
+#include <queue>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Every thread gets a small index, unique among the threads alive at the time and recycled
+// when a thread exits, so a structure can give each thread its own slot in a fixed array.
+unsigned const max_combining_threads = 256;
+
+std::atomic<bool> combining_index_taken[max_combining_threads];
+std::atomic<unsigned> combining_index_high_water{ 0 };
+
+class combining_index_owner {
+	unsigned index;
+public:
+	combining_index_owner(combining_index_owner const&) = delete;
+	combining_index_owner& operator=(combining_index_owner const&) = delete;
+
+	combining_index_owner() : index(max_combining_threads) {
+		for (unsigned i = 0; i < max_combining_threads; ++i) {
+			if (!combining_index_taken[i].exchange(true)) {
+				index = i;
+				break;
+			}
+		}
+		if (index == max_combining_threads) {
+			throw std::runtime_error("No flat combining slots available");
+		}
+		unsigned high_water = combining_index_high_water.load();
+		while (high_water <= index && !combining_index_high_water.compare_exchange_weak(high_water, index + 1));
+	}
+
+	unsigned get() const {
+		return index;
+	}
+
+	~combining_index_owner() {
+		combining_index_taken[index].store(false);
+	}
+};
+
+unsigned combining_index_for_current_thread() {
+	thread_local static combining_index_owner owner;
+	return owner.get();
+}
+
+// Flat combining (Hendler, Incze, Shavit, Tzafrir): a thread publishes the operation it wants
+// in its own padded record and then either waits for it to be done or, if nobody else is
+// combining, takes the lock and runs every published operation itself. The container is only
+// ever touched by the one combiner, so it stays in that core's cache while the batch runs, and
+// the lock changes hands once per batch instead of once per operation.
+template<typename Container>
+class flat_combining {
+	struct alignas(std::hardware_destructive_interference_size) publication_record {
+		std::atomic<bool> pending{ false };
+		void (*run)(Container&, void*) = nullptr;
+		void* operation = nullptr;
+		std::exception_ptr error; // set by the combiner, rethrown on the publishing thread
+	};
+
+	// the combiner keeps scanning while it keeps finding work, up to this many passes
+	static constexpr unsigned max_passes = 4;
+
+	alignas(std::hardware_destructive_interference_size) std::mutex combiner_mutex;
+	Container container;
+	publication_record records[max_combining_threads];
+
+	void combine() {
+		for (unsigned pass = 0; pass < max_passes; ++pass) {
+			bool found_work = false;
+			unsigned const high_water = combining_index_high_water.load(std::memory_order_acquire);
+			for (unsigned i = 0; i < high_water; ++i) {
+				publication_record& record = records[i];
+				if (record.pending.load(std::memory_order_acquire)) {
+					try {
+						record.run(container, record.operation);
+					}
+					catch (...) {
+						record.error = std::current_exception();
+					}
+					record.pending.store(false, std::memory_order_release);
+					found_work = true;
+				}
+			}
+			if (!found_work) {
+				break;
+			}
+		}
+	}
+
+	template<typename Operation>
+	static void run_operation(Container& c, void* operation) {
+		(*static_cast<Operation*>(operation))(c);
+	}
+
+public:
+	flat_combining() {}
+
+	flat_combining(flat_combining const&) = delete;
+	flat_combining& operator=(flat_combining const&) = delete;
+
+	// runs op(container) as if under a lock around the container and returns its result; op
+	// runs on whichever thread is combining, so it must not depend on the calling thread.
+	// If op throws, the exception is rethrown here, on the thread that called apply.
+	template<typename Operation> requires std::invocable<Operation&, Container&>
+	std::invoke_result_t<Operation&, Container&> apply(Operation op) {
+		typedef std::invoke_result_t<Operation&, Container&> result_type;
+		if constexpr (std::is_void_v<result_type>) {
+			auto wrapped = [&op](Container& c) { op(c); };
+			publish_and_wait(wrapped);
+		}
+		else {
+			std::optional<result_type> result;
+			auto wrapped = [&op, &result](Container& c) { result.emplace(op(c)); };
+			publish_and_wait(wrapped);
+			return std::move(*result);
+		}
+	}
+
+private:
+	template<typename Operation>
+	void publish_and_wait(Operation& op) {
+		publication_record& record = records[combining_index_for_current_thread()];
+		record.run = &run_operation<Operation>;
+		record.operation = &op;
+		record.pending.store(true, std::memory_order_release);
+		while (record.pending.load(std::memory_order_acquire)) {
+			std::unique_lock<std::mutex> lk(combiner_mutex, std::try_to_lock);
+			if (lk.owns_lock()) {
+				combine();
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		if (record.error) {
+			std::rethrow_exception(std::exchange(record.error, nullptr));
+		}
+	}
+};
+
+// the baseline: the same apply interface with every operation taking the mutex, as 6/1 and 6/5 do
+template<typename Container>
+class mutex_wrapped {
+	std::mutex m;
+	Container container;
+public:
+	template<typename Operation> requires std::invocable<Operation&, Container&>
+	std::invoke_result_t<Operation&, Container&> apply(Operation op) {
+		std::lock_guard<std::mutex> lk(m);
+		return op(container);
+	}
+};
+
+template<typename T>
+T const& next_out(std::queue<T> const& q) {
+	return q.front();
+}
+
+template<typename Container>
+typename Container::value_type const& next_out(Container const& c) {
+	return c.top();
+}
+
+template<typename Container>
+std::optional<typename Container::value_type> try_pop(Container& c) {
+	if (c.empty()) {
+		return std::nullopt;
+	}
+	std::optional<typename Container::value_type> value(next_out(c));
+	c.pop();
+	return value;
+}
+
+// every thread alternates pushes and pops on one shared structure
+template<template<typename> typename Wrapper, typename Container>
+void run_benchmark(std::string const& name, int num_threads) {
+	const int total_ops = 1 << 18;
+	const int ops_per_thread = total_ops / num_threads;
+	Wrapper<Container> wrapped;
+	std::atomic<long long> popped_sum{ 0 };
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&wrapped, &popped_sum, ops_per_thread]() {
+			long long sum = 0;
+			for (int i = 0; i < ops_per_thread; ++i) {
+				if (i % 2 == 0) {
+					wrapped.apply([i](Container& c) { c.push(i); });
+				}
+				else if (auto const value = wrapped.apply([](Container& c) { return try_pop(c); })) {
+					sum += *value;
+				}
+			}
+			popped_sum += sum;
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	long long const remaining = wrapped.apply([](Container& c) {
+		long long sum = 0;
+		while (auto const value = try_pop(c)) {
+			sum += *value;
+		}
+		return sum;
+		});
+	long long const pushed_per_thread = (long long)(ops_per_thread / 2) * (ops_per_thread / 2 - 1);
+	assert(popped_sum + remaining == pushed_per_thread * num_threads);
+	(void)remaining;
+	(void)pushed_per_thread;
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("{:<40} {:>2} threads: {:>7.1f} ns/op", name, num_threads, duration.count() / (double(num_threads) * ops_per_thread));
+}
+
+template<typename Container>
+void run_benchmarks(std::string const& container_name) {
+	for (int num_threads : { 8, 16, 32, 64 }) {
+		run_benchmark<mutex_wrapped, Container>("mutex_wrapped<" + container_name + ">", num_threads);
+		run_benchmark<flat_combining, Container>("flat_combining<" + container_name + ">", num_threads);
+	}
+}
+
+int main() {
+	flat_combining<std::queue<int>> queue;
+	{
+		std::vector<std::jthread> producers;
+		for (int t = 0; t < 4; ++t) {
+			producers.emplace_back([&queue, t]() {
+				for (int i = 0; i < 1000; ++i) {
+					queue.apply([t, i](std::queue<int>& q) { q.push(t * 1000 + i); });
+				}
+				});
+		}
+	}
+	std::vector<int> last_seen(4, -1);
+	while (auto const value = queue.apply([](std::queue<int>& q) { return try_pop(q); })) {
+		int const producer = *value / 1000;
+		assert(*value % 1000 == last_seen[producer] + 1); // each producer's items stay in order
+		last_seen[producer] = *value % 1000;
+	}
+	assert(last_seen == std::vector<int>(4, 999));
+
+	flat_combining<std::priority_queue<int>> heap;
+	for (int value : { 3, 1, 4, 1, 5, 9, 2, 6 }) {
+		heap.apply([value](std::priority_queue<int>& h) { h.push(value); });
+	}
+	assert(heap.apply([](std::priority_queue<int>& h) { return try_pop(h); }) == 9);
+
+	// a throwing operation fails only its own apply, whichever thread ran it
+	flat_combining<std::queue<int>> failing;
+	{
+		std::vector<std::jthread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([&failing]() {
+				int caught = 0;
+				for (int i = 0; i < 100; ++i) {
+					try {
+						failing.apply([i](std::queue<int>& q) {
+							if (i % 10 == 0) {
+								throw std::runtime_error("operation failed");
+							}
+							q.push(i);
+							});
+					}
+					catch (std::runtime_error const&) {
+						++caught;
+					}
+				}
+				assert(caught == 10);
+				(void)caught;
+				});
+		}
+	}
+	assert(failing.apply([](std::queue<int>& q) { return q.size(); }) == 4 * 90);
+	std::println("Test passed!");
+
+	run_benchmarks<std::queue<int>>("std::queue<int>");
+	run_benchmarks<std::stack<int>>("std::stack<int>");
+	run_benchmarks<std::priority_queue<int>>("std::priority_queue<int>");
+	return 0;
+}
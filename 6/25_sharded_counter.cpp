@@ -0,0 +1,175 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sharded_counter.h"
+
+// the single shared atomic every driver in 6/1-6/7 used, behind the same interface
+class single_atomic_counter {
+	std::atomic<long long> value{ 0 };
+public:
+	void add(long long n) {
+		value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	long long read() const {
+		return value.load(std::memory_order_relaxed);
+	}
+};
+
+// Listing 6.4 queue with one mutex, as in 6/5
+template<typename T>
+class threadsafe_queue {
+private:
+	struct node {
+		std::shared_ptr<T> data;
+		std::unique_ptr<node> next;
+	};
+
+	mutable std::mutex mut;
+	std::unique_ptr<node> head;
+	node* tail;
+public:
+	threadsafe_queue() : head(new node), tail(head.get()) {}
+	threadsafe_queue(const threadsafe_queue&) = delete;
+	threadsafe_queue& operator=(const threadsafe_queue&) = delete;
+
+	std::shared_ptr<T> try_pop() {
+		std::lock_guard<std::mutex> lk(mut);
+		if (head.get() == tail) {
+			return std::shared_ptr<T>();
+		}
+		std::shared_ptr<T> res = head->data;
+		std::unique_ptr<node> old_head = std::move(head);
+		head = std::move(old_head->next);
+		return res;
+	}
+
+	void push(T new_value) {
+		std::shared_ptr<T> new_data(std::make_shared<T>(std::move(new_value)));
+		std::unique_ptr<node> p(new node);
+		node* const new_tail = p.get();
+		std::lock_guard<std::mutex> lk(mut);
+		tail->data = new_data;
+		tail->next = std::move(p);
+		tail = new_tail;
+	}
+};
+
+template<typename Counter>
+void run_counter_benchmark(std::string const& name, int num_threads) {
+	const int adds_per_thread = 1000000;
+	Counter counter;
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&counter]() {
+			for (int i = 0; i < adds_per_thread; ++i) {
+				counter.add(1);
+			}
+			});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	assert(counter.read() == (long long)num_threads * adds_per_thread);
+	std::chrono::duration<double, std::nano> duration = end - start;
+	std::println("add()   {:<40} {:>2} threads: {:>6.2f} ns/add", name, num_threads, duration.count() / (double(num_threads) * adds_per_thread));
+}
+
+// the 6/5 driver; with CountLocally each consumer keeps a plain local count and adds it to the
+// counter once at the end, which takes the counter out of the measurement altogether
+template<typename Counter, bool CountLocally = false>
+void run_queue_benchmark(std::string const& name, int num_pairs) {
+	const int items_per_producer = 100000;
+	threadsafe_queue<int> queue;
+	Counter processed_count;
+	std::atomic<bool> producers_finished{ false };
+
+	std::vector<std::thread> producers;
+	std::vector<std::thread> consumers;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < num_pairs; ++i) {
+		consumers.emplace_back([&queue, &processed_count, &producers_finished]() {
+			long long local_count = 0;
+			auto count_item = [&]() {
+				if constexpr (CountLocally) {
+					++local_count;
+				}
+				else {
+					processed_count.add(1);
+				}
+			};
+			while (true) {
+				if (queue.try_pop()) {
+					count_item();
+				}
+				else if (producers_finished.load(std::memory_order_acquire)) {
+					if (!queue.try_pop()) {
+						break;
+					}
+					count_item();
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+			if constexpr (CountLocally) {
+				processed_count.add(local_count);
+			}
+			});
+	}
+	for (int i = 0; i < num_pairs; ++i) {
+		producers.emplace_back([&queue]() {
+			for (int i = 0; i < items_per_producer; ++i) {
+				queue.push(i);
+			}
+			});
+	}
+	for (auto& t : producers) {
+		t.join();
+	}
+	producers_finished.store(true, std::memory_order_release);
+	for (auto& t : consumers) {
+		t.join();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	assert(processed_count.read() == (long long)num_pairs * items_per_producer);
+	std::chrono::duration<double, std::milli> duration = end - start;
+	std::println("queue   {:<40} {:>2} producers + {:>2} consumers: {:>6.2f} M items/s",
+		name, num_pairs, num_pairs, num_pairs * items_per_producer / duration.count() / 1e3);
+}
+
+int main() {
+	sharded_counter counter(4);
+	{
+		std::vector<std::jthread> threads;
+		for (int t = 0; t < 8; ++t) {
+			threads.emplace_back([&counter, t]() {
+				for (int i = 0; i < 1000; ++i) {
+					counter.add(t);
+				}
+				});
+		}
+	}
+	assert(counter.read() == 1000LL * (0 + 1 + 2 + 3 + 4 + 5 + 6 + 7));
+	std::println("Test passed!");
+
+	for (int num_threads : { 1, 2, 4, 8, 16, 32, 64 }) {
+		run_counter_benchmark<single_atomic_counter>("single std::atomic", num_threads);
+		run_counter_benchmark<sharded_counter>("sharded_counter", num_threads);
+	}
+	for (int num_pairs : { 4, 16, 32 }) {
+		run_queue_benchmark<single_atomic_counter>("single std::atomic per item", num_pairs);
+		run_queue_benchmark<sharded_counter>("sharded_counter per item", num_pairs);
+		run_queue_benchmark<single_atomic_counter, true>("local counts, one add per consumer", num_pairs);
+	}
+	return 0;
+}
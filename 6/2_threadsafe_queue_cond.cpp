@@ -9,6 +9,8 @@
 #include <thread>
 #include <vector>
 
+#include "sharded_counter.h"
+
 template<typename T>
 class threadsafe_queue {
 private:
@@ -65,7 +67,7 @@ public:
 	}
 };
 
-std::atomic<int> counter{ 0 };
+sharded_counter counter;
 std::atomic<bool> done{ false };
 
 void producer(threadsafe_queue<int>& q, int items) {
@@ -84,7 +86,7 @@ void consumer(threadsafe_queue<int>& q) {
 			std::this_thread::yield();
 		}
 		else {
-			counter.fetch_add(1);
+			counter.add(1);
 		}
 	}
 }
@@ -99,7 +101,7 @@ void consumer_ptr(threadsafe_queue<int>& q) {
 			std::this_thread::yield();
 		}
 		else {
-			counter.fetch_add(1);
+			counter.add(1);
 		}
 	}
 }
@@ -131,8 +133,8 @@ int main() {
 		c.join();
 	}
 
-	std::cout << "Processed: " << counter.load() << std::endl;
+	std::cout << "Processed: " << counter.read() << std::endl;
 	std::cout << "Expected: " << items * producers_count << std::endl;
 
-	assert(counter.load() == items * producers_count);
+	assert(counter.read() == items * producers_count);
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include <thread>
 #include <vector>
 
+#include "sharded_counter.h"
+
 template<typename T>
 class threadsafe_queue {
 private:
@@ -43,9 +45,9 @@ public:
 		tail->next = std::move(p);
 		tail = new_tail;
 	}
-};
-
-std::atomic<int> processed_count{ 0 };
+};
+
+sharded_counter processed_count;
 std::atomic<bool> producers_finished{ false };
 
 void producer(threadsafe_queue<int>& q, int items_count) {
@@ -58,7 +60,7 @@ void consumer(threadsafe_queue<int>& q) {
 	while (true) {
 		auto data = q.try_pop();
 		if (data) {
-			processed_count.fetch_add(1, std::memory_order_relaxed);
+			processed_count.add(1);
 		}
 		else {
 			if (producers_finished.load(std::memory_order_acquire)) {
@@ -67,7 +69,7 @@ void consumer(threadsafe_queue<int>& q) {
 					break;
 				}
 				else {
-					processed_count.fetch_add(1, std::memory_order_relaxed);
+					processed_count.add(1);
 				}
 			}
 			else {
@@ -114,7 +116,7 @@ int main() {
 	std::println("Estimated: {}", std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time));
 
 	int expected_items = num_producers * items_per_producer;
-	int actual_items = processed_count.load();
+	long long actual_items = processed_count.read();
 
 	std::println("Expected items: {}", expected_items);
 	std::println("Processed items: {}", actual_items);
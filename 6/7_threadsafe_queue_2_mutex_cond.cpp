@@ -8,6 +8,8 @@
 #include <thread>
 #include <vector>
 
+#include "sharded_counter.h"
+
 template<typename T>
 class threadsafe_queue {
 private:
@@ -86,7 +88,7 @@ public:
 	}
 };
 
-std::atomic<int> processed_count{ 0 };
+sharded_counter processed_count;
 const int POISON_PILL = -1;
 
 void producer(threadsafe_queue<int>& q, int count) {
@@ -103,7 +105,7 @@ void consumer(threadsafe_queue<int>& q, int id) {
 			if (value == POISON_PILL) {
 				break;
 			}
-			processed_count.fetch_add(1, std::memory_order_relaxed);
+			processed_count.add(1);
 		}
 	}
 }
@@ -147,7 +149,7 @@ int main() {
 
 
 	int expected_items = num_producers * items_per_producer;
-	int actual_items = processed_count.load();
+	long long actual_items = processed_count.read();
 
 	std::println("Expected items: {}", expected_items);
 	std::println("Processed items: {}", actual_items);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+// Big-reader lock: each reader thread is given one of a set of padded slots and only ever
+// writes to that slot, so readers on different slots never bounce a cache line between them.
+// A writer raises the writer flag, which turns new readers away, then waits for every slot
+// to drain. Reads get cheaper and writes get more expensive, so it suits read-mostly data.
+class big_reader_mutex {
+	struct alignas(std::hardware_destructive_interference_size) reader_slot {
+		std::atomic<unsigned> readers{ 0 };
+	};
+
+	unsigned const num_slots;
+	std::unique_ptr<reader_slot[]> slots;
+	alignas(std::hardware_destructive_interference_size) std::atomic<bool> writer{ false };
+	std::mutex writer_mutex;
+
+	static unsigned default_slots() {
+		unsigned const concurrency = std::thread::hardware_concurrency();
+		return (concurrency > 0) ? concurrency : 2;
+	}
+
+	reader_slot& slot_for_current_thread() {
+		static std::atomic<unsigned> next_thread{ 0 };
+		thread_local unsigned const thread_index = next_thread.fetch_add(1);
+		return slots[thread_index % num_slots];
+	}
+
+public:
+	explicit big_reader_mutex(unsigned num_slots_ = default_slots()) :
+		num_slots(num_slots_), slots(new reader_slot[num_slots_]) {}
+
+	big_reader_mutex(big_reader_mutex const&) = delete;
+	big_reader_mutex& operator=(big_reader_mutex const&) = delete;
+
+	void lock_shared() {
+		reader_slot& slot = slot_for_current_thread();
+		while (true) {
+			slot.readers.fetch_add(1);
+			if (!writer.load()) {
+				return;
+			}
+			slot.readers.fetch_sub(1, std::memory_order_release);
+			while (writer.load(std::memory_order_relaxed)) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	bool try_lock_shared() {
+		reader_slot& slot = slot_for_current_thread();
+		slot.readers.fetch_add(1);
+		if (!writer.load()) {
+			return true;
+		}
+		slot.readers.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+
+	void unlock_shared() {
+		slot_for_current_thread().readers.fetch_sub(1, std::memory_order_release);
+	}
+
+	void lock() {
+		writer_mutex.lock();
+		writer.store(true);
+		for (unsigned i = 0; i < num_slots; ++i) {
+			while (slots[i].readers.load() != 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	bool try_lock() {
+		if (!writer_mutex.try_lock()) {
+			return false;
+		}
+		writer.store(true);
+		for (unsigned i = 0; i < num_slots; ++i) {
+			if (slots[i].readers.load() != 0) {
+				writer.store(false);
+				writer_mutex.unlock();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void unlock() {
+		writer.store(false, std::memory_order_release);
+		writer_mutex.unlock();
+	}
+};
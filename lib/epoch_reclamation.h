@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+// Epoch-based reclamation. Threads announce the global epoch while inside a traversal;
+// the epoch only advances once every active thread has caught up, and on moving to e + 1
+// everything retired in epoch e - 2 can no longer be reached and is deleted.
+inline constexpr unsigned max_epoch_slots = 128;
+
+struct alignas(std::hardware_destructive_interference_size) epoch_slot {
+	std::atomic<std::thread::id> id;
+	std::atomic<unsigned> announced{ 0 }; // (epoch << 1) | 1 while inside a traversal
+};
+
+inline epoch_slot epoch_slots[max_epoch_slots];
+inline std::atomic<unsigned> global_epoch{ 0 };
+
+template<typename T>
+void do_delete(void* p) {
+	delete static_cast<T*>(p);
+}
+
+struct data_to_reclaim {
+	void* data;
+	std::function<void(void*)> deleter;
+	data_to_reclaim* next;
+
+	template<typename T>
+	data_to_reclaim(T* p) : data(p), deleter(&do_delete<T>), next(nullptr) {}
+
+	~data_to_reclaim() {
+		deleter(data);
+	}
+};
+
+inline void delete_reclaim_list(data_to_reclaim* current) {
+	while (current) {
+		data_to_reclaim* const next = current->next;
+		delete current;
+		current = next;
+	}
+}
+
+// one list per epoch modulo 3; whatever is left is freed at program exit
+struct limbo_lists {
+	std::atomic<data_to_reclaim*> lists[3];
+	~limbo_lists() {
+		for (auto& list : lists) {
+			delete_reclaim_list(list.load());
+		}
+	}
+};
+
+inline limbo_lists limbo;
+inline std::mutex advance_mutex;
+
+class epoch_owner {
+	epoch_slot* slot;
+public:
+	unsigned depth = 0;
+
+	epoch_owner(epoch_owner const&) = delete;
+	epoch_owner& operator=(epoch_owner const&) = delete;
+
+	epoch_owner() : slot(nullptr) {
+		for (unsigned i = 0; i < max_epoch_slots; ++i) {
+			std::thread::id old_id;
+			if (epoch_slots[i].id.compare_exchange_strong(old_id, std::this_thread::get_id())) {
+				slot = &epoch_slots[i];
+				break;
+			}
+		}
+		if (!slot) {
+			throw std::runtime_error("No epoch slots available");
+		}
+	}
+
+	std::atomic<unsigned>& get_announcement() {
+		return slot->announced;
+	}
+
+	~epoch_owner() {
+		slot->announced.store(0);
+		slot->id.store(std::thread::id());
+	}
+};
+
+inline epoch_owner& get_epoch_owner_for_current_thread() {
+	thread_local static epoch_owner owner;
+	return owner;
+}
+
+inline void try_advance_epoch() {
+	std::unique_lock<std::mutex> lk(advance_mutex, std::try_to_lock);
+	if (!lk.owns_lock()) {
+		return;
+	}
+	unsigned const epoch = global_epoch.load();
+	for (unsigned i = 0; i < max_epoch_slots; ++i) {
+		unsigned const announced = epoch_slots[i].announced.load();
+		if ((announced & 1) && (announced >> 1) != epoch) {
+			return;
+		}
+	}
+	// nobody can retire into this list until the new epoch is published
+	data_to_reclaim* const expired = limbo.lists[(epoch + 1) % 3].exchange(nullptr);
+	global_epoch.store(epoch + 1);
+	lk.unlock();
+	delete_reclaim_list(expired);
+}
+
+// marks the calling thread as inside a traversal; nested guards share the outer announcement
+class epoch_guard {
+	epoch_owner& owner;
+public:
+	epoch_guard(epoch_guard const&) = delete;
+	epoch_guard& operator=(epoch_guard const&) = delete;
+
+	epoch_guard() : owner(get_epoch_owner_for_current_thread()) {
+		if (owner.depth++ > 0) {
+			return;
+		}
+		std::atomic<unsigned>& announced = owner.get_announcement();
+		unsigned epoch;
+		do {
+			epoch = global_epoch.load();
+			announced.store((epoch << 1) | 1);
+		} while (global_epoch.load() != epoch);
+	}
+
+	~epoch_guard() {
+		if (--owner.depth == 0) {
+			owner.get_announcement().store(0);
+		}
+	}
+
+	template<typename T>
+	void retire(T* p) {
+		unsigned const epoch = owner.get_announcement().load() >> 1;
+		data_to_reclaim* const node = new data_to_reclaim(p);
+		std::atomic<data_to_reclaim*>& list = limbo.lists[epoch % 3];
+		node->next = list.load();
+		while (!list.compare_exchange_weak(node->next, node));
+		thread_local static unsigned retired_since_advance = 0;
+		if (++retired_since_advance >= 64) {
+			retired_since_advance = 0;
+			try_advance_epoch();
+		}
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+
+// A counter spread over padded cells. Each thread always adds to the same cell, chosen by a
+// per-thread index, so threads on different cells never contend for a cache line and add()
+// stays an uncontended relaxed fetch_add. read() sums the cells; it is exact once the adding
+// threads are done, and while they run it returns some value between the old and new totals.
+// With more threads than cells some threads share a cell, which is still correct, just slower.
+class sharded_counter {
+	struct alignas(std::hardware_destructive_interference_size) cell {
+		std::atomic<long long> value{ 0 };
+	};
+
+	static constexpr unsigned default_cells = 64;
+
+	unsigned const num_cells;
+	std::unique_ptr<cell[]> cells;
+
+	cell& cell_for_current_thread() {
+		static std::atomic<unsigned> next_thread{ 0 };
+		thread_local unsigned const thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+		return cells[thread_index % num_cells];
+	}
+
+public:
+	explicit sharded_counter(unsigned num_cells_ = default_cells) : num_cells(num_cells_), cells(new cell[num_cells_]) {}
+
+	sharded_counter(sharded_counter const&) = delete;
+	sharded_counter& operator=(sharded_counter const&) = delete;
+
+	void add(long long n) {
+		cell_for_current_thread().value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	long long read() const {
+		long long total = 0;
+		for (unsigned i = 0; i < num_cells; ++i) {
+			total += cells[i].value.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+};